@@ -19,87 +19,490 @@
 
 using namespace dengue::standard;
 
-const Parameters* Community::_par;
-vector< set<Location*, LocPtrComp> > Community::_isHot;
-set<Person*> Community::_revaccinate_set;
-vector<Person*> Community::_peopleByAge;
-map<int, set<pair<Person*,Person*> > > Community::_delayedBirthdays;
+static const unsigned int NO_BITER = UINT_MAX;                        // end of a bite group's list of biters
+const unsigned int Community::REDUCTION_BLOCKS;
 
 int mod(int k, int n) { return ((k %= n) < 0) ? k+n : k; } // correct for non-negative n
 
 Community::Community(const Parameters* parameters) :
+    _par(parameters),
+    _rng(parameters->randomseed),
+    _occupancy(_people),
     _exposedQueue(MAX_INCUBATION, vector<Person*>(0)),
-    _infectiousMosquitoQueue(MAX_MOSQUITO_AGE+1, vector<Mosquito*>(0)),
-    // reserving MAX_MOSQUITO_AGE is simpler than figuring out what the maximum
-    // possible EIP is when EIP is variable
-    _exposedMosquitoQueue(MAX_MOSQUITO_AGE+1, vector<Mosquito*>(0)),
+    _threadPool(parameters->nThreads, parameters->nFirstCore),
     _nNumNewlyInfected(NUM_OF_SEROTYPES, vector<int>(parameters->nRunLength + MAX_MOSQUITO_AGE)), // +1 not needed; nRunLength is already a valid size
     _nNumNewlySymptomatic(NUM_OF_SEROTYPES, vector<int>(parameters->nRunLength + MAX_MOSQUITO_AGE)),
     _nNumVaccinatedCases(NUM_OF_SEROTYPES, vector<int>(parameters->nRunLength + MAX_MOSQUITO_AGE)),
-    _nNumSevereCases(NUM_OF_SEROTYPES, vector<int>(parameters->nRunLength + MAX_MOSQUITO_AGE))
+    _nNumSevereCases(NUM_OF_SEROTYPES, vector<int>(parameters->nRunLength + MAX_MOSQUITO_AGE)),
+    _nTalliedDays(0),
+    // flagged days run from an infection's infectious time up to (but not including) its recovery time
+    _isHot(MAX_INCUBATION + INFECTIOUS_PERIOD_SEVERE + 1),
+    // an infection's events run from its infectious time through its recovery time
+    _diseaseEvents(MAX_INCUBATION + INFECTIOUS_PERIOD_SEVERE + 1),
+    _nActiveInfectionsDay(INT_MIN),
+    _bActiveInfectionsSorted(true)
     {
-    _par = parameters;
     _nDay = 0;
+    _nRun = 0;
     _fMosquitoCapacityMultiplier = 1.0;
     _expectedEIP = -1;
     _EIP_emu = -1;
     _fMortality = NULL;
     _bNoSecondaryTransmission = false;
     _uniformSwap = true;
+    _bWeightedMosquitoMove = (parameters->mosquitoMoveModel == "weighted");
+    _structure = this;
+    _nBitingRound = 0;
     for (int a = 0; a<NUM_AGE_CLASSES; a++) _nPersonAgeCohortSizes[a] = 0;
-    _isHot.resize(_par->nRunLength);
+    _buildTiles();                                                    // rebuilt once locations are loaded
+    // results do not depend on the number of bite blocks, so there are just enough to balance the threads' work
+    const unsigned int nblocks = _threadPool.size() == 1 ? 1 : 8 * _threadPool.size();
+    for (unsigned int b = 0; b < nblocks; ++b) _biteBlockRNG.push_back(gsl_rng_alloc(rng_philox4x32));
+    _biteBlockBites.resize(nblocks);
 }
 
 
-void Community::reset() { // used for r-zero calculations, to reset pop after a single intro
-    // reset people
-    for (Person* p: _people) {
+// A replicate of structure, as build_community() would make it with parameters, but without reading any files:
+// everything that does not change during a run (the people's and locations' attributes, swap probabilities,
+// mosquito movement and initial immunity) is shared with structure, which must outlive the replicate.  The
+// replicate has its own people and locations, which hold only their immune, infection, mosquito and vector
+// control state, and its own occupancy.
+Community::Community(const Community* structure, const Parameters* parameters) : Community(parameters) {
+    _structure = structure;
+    if (!_addLocations()) exit(-1);
+    _buildTiles();
+    _addPeople();
+    _uniformSwap = structure->_uniformSwap;
+    _applyInitialImmunity();
+}
+
+
+SpatialTile::SpatialTile(unsigned int n, unsigned int ntiles, const vector<Location*>& alllocations, const RandomStreams* communityStreams) :
+    id(n),
+    mosquitoes(alllocations, n, ntiles),                              // mosquito IDs are unique across tiles
+    infectiousMosquitoQueue(MAX_MOSQUITO_AGE+1),
+    // reserving MAX_MOSQUITO_AGE is simpler than figuring out what the maximum
+    // possible EIP is when EIP is variable
+    exposedMosquitoQueue(MAX_MOSQUITO_AGE+1),
+    infectiousMosquitoCohorts(MAX_MOSQUITO_AGE+1),
+    exposedMosquitoCohorts(MAX_MOSQUITO_AGE+1),
+    _streams(communityStreams->getSeed(), n+1) {}
+
+
+void SpatialTile::reseed(unsigned long int seed) {
+    _streams.reseed(seed);
+}
+
+
+// Used for r-zero calculations, to reset the population after a single introduction.  Only the people changed
+// since the last reset (see _markChanged()) and the locations they or the surviving infected mosquitoes are
+// counted at are restored, so a reset after a small outbreak costs little however large the community is.
+void Community::reset() {
+    // reset people, in ID order, since people going back to work rejoin their workplaces' lists of occupants.
+    // everyone goes back to work before any location's viremia tallies are cleared, since the tallies of a
+    // withdrawn person's home may also be cleared by someone else who is viremic there
+    sort(_changedPeople.begin(), _changedPeople.end(), PerIDComp());
+    for (Person* p: _changedPeople) {
         if (p->isWithdrawn(_nDay)) {
             p->getLocation(WORK_DAY)->addPerson(p,WORK_DAY);                    // goes back to work
-            p->getLocation(HOME_MORNING)->removePerson(p,WORK_DAY);             // stops staying at home
+            _addViremiaTally(p, p->getLocation(WORK_DAY));
+            if (p->getLocation(HOME_MORNING)->removePerson(p,WORK_DAY)) {       // stops staying at home
+                _removeViremiaTally(p, p->getLocation(HOME_MORNING));
+            }
         }
+    }
+    for (Person* p: _changedPeople) {
         p->resetImmunity(); // no past infections, not dead, not vaccinated
+        ViremiaTally &vt = _viremiaTally[p->getID()];
+        if (vt.viremic) {                                             // no one else at these locations is viremic
+            for (int t=0; t<(int) NUM_OF_TIME_PERIODS; t++) if (vt.location[t]) vt.location[t]->clearViremic();
+            for (Location* loc: vt.extraWorkDay) loc->clearViremic();
+        }
+        vt.viremic = vt.vaccinated = false;
+        vt.serotype = NULL_SEROTYPE;
+        _isChangedPerson[p->getID()] = false;
     }
+    _changedPeople.clear();
+    _delayedBirthdays.clear();
+    _revaccinate_set.clear();
 
-    // reset locations
-    for (unsigned int i = 0; i < _location.size(); i++ ) _location[i]->clearInfectedMosquitoes();
-
-    for (auto &e: _isHot) e.clear();
+    _isHot.clear();
+    _diseaseEvents.clear();
+    for (Person* p: _activeInfections) _isActiveInfection[p->getID()] = false;
+    _activeInfections.clear();
+    _nActiveInfectionsDay = INT_MIN;
 
     // clear community queues & tallies
     for (unsigned int i = 0; i < _exposedQueue.size(); i++ ) _exposedQueue[i].clear();
-    _exposedQueue.clear();
 
-    for (unsigned int i = 0; i < _infectiousMosquitoQueue.size(); i++ ) _infectiousMosquitoQueue[i].clear();
-    _infectiousMosquitoQueue.clear();
+    for (SpatialTile* tile: _tiles) {
+        // the locations' infected mosquito counts are kept up to date, so only the survivors' locations are counted
+        for (unsigned int i = 0; i < tile->infectiousMosquitoQueue.size(); i++) {
+            for (unsigned int m: tile->infectiousMosquitoQueue[i]) tile->mosquitoes.getLocation(m)->clearInfectedMosquitoes();
+        }
+        for (unsigned int i = 0; i < tile->exposedMosquitoQueue.size(); i++) {
+            for (unsigned int m: tile->exposedMosquitoQueue[i]) tile->mosquitoes.getLocation(m)->clearInfectedMosquitoes();
+        }
+        for (unsigned int i = 0; i < tile->infectiousMosquitoCohorts.size(); i++) {
+            for (const MosquitoCohort &c: tile->infectiousMosquitoCohorts[i]) _location[c.locationID]->clearInfectedMosquitoes();
+        }
+        for (unsigned int i = 0; i < tile->exposedMosquitoCohorts.size(); i++) {
+            for (const MosquitoCohort &c: tile->exposedMosquitoCohorts[i]) _location[c.locationID]->clearInfectedMosquitoes();
+        }
+        tile->mosquitoes.clear();
+        tile->infectiousMosquitoQueue.clear();
+        tile->exposedMosquitoQueue.clear();
+        tile->infectiousMosquitoCohorts.clear();
+        tile->exposedMosquitoCohorts.clear();
+        tile->hot.clear();
+        tile->bites.clear();
+        for (vector<unsigned int> &b: tile->bitesByBlock) b.clear();
+        tile->outbox.clear();
+    }
 
-    for (unsigned int i = 0; i < _exposedMosquitoQueue.size(); i++ ) _exposedMosquitoQueue[i].clear();
-    _exposedMosquitoQueue.clear();
+    // tallies are only written on days that have been simulated, unless the run length has changed (see restart())
+    const unsigned int tallyDays = _par->nRunLength + MAX_MOSQUITO_AGE;
+    for (vector< vector<int> >* tally: {&_nNumNewlyInfected, &_nNumNewlySymptomatic, &_nNumVaccinatedCases, &_nNumSevereCases}) {
+        for (vector<int> &counts: *tally) {
+            if (counts.size() == tallyDays) {
+                fill(counts.begin(), counts.begin() + min(_nTalliedDays, tallyDays), 0);
+            } else {
+                counts.assign(tallyDays, 0);
+            }
+        }
+    }
+    _nTalliedDays = 0;
+    ++_nRun;                                                          // the next run's people draw from streams of its own
+}
 
-    for (unsigned int i = 0; i < _nNumNewlyInfected.size(); i++ ) _nNumNewlyInfected[i].clear();
-    _nNumNewlyInfected.clear();
 
-    for (unsigned int i = 0; i < _nNumNewlySymptomatic.size(); i++ ) _nNumNewlySymptomatic[i].clear();
-    _nNumNewlySymptomatic.clear();
+// Can this community be restarted with par, i.e., would build_community(par) read the same files into the same
+// tiles, and use the same threads?
+bool Community::canRestart(const Parameters* par) const {
+    return par->locationFilename == _par->locationFilename and par->networkFilename == _par->networkFilename
+        and par->populationFilename == _par->populationFilename and par->immunityFilename == _par->immunityFilename
+        and par->swapProbFilename == _par->swapProbFilename
+        and par->nSpatialTiles == _par->nSpatialTiles and par->nThreads == _par->nThreads and par->nFirstCore == _par->nFirstCore;
+}
 
-    for (unsigned int i = 0; i < _nNumVaccinatedCases.size(); i++ ) _nNumVaccinatedCases[i].clear();
-    _nNumVaccinatedCases.clear();
 
-    _exposedQueue.resize(MAX_INCUBATION, vector<Person*>(0));
-    _infectiousMosquitoQueue.resize(MAX_MOSQUITO_AGE+1, vector<Mosquito*>(0));
-    _exposedMosquitoQueue.resize(MAX_MOSQUITO_AGE+1, vector<Mosquito*>(0));
-    _nNumNewlyInfected.resize(NUM_OF_SEROTYPES, vector<int>(_par->nRunLength + MAX_MOSQUITO_AGE));
-    _nNumNewlySymptomatic.resize(NUM_OF_SEROTYPES, vector<int>(_par->nRunLength + MAX_MOSQUITO_AGE));
-    _nNumVaccinatedCases.resize(NUM_OF_SEROTYPES, vector<int>(_par->nRunLength + MAX_MOSQUITO_AGE));
+// Returns the community to the state in which build_community() leaves it, but with new parameters and without
+// reading any files.  The random streams are reseeded, mosquito capacities are sampled again and the initial
+// immunity is re-applied, all in the same order as when the community was built, so a restarted community
+// gives the same results as a new one.  Secondary transmission is turned back on, and mosquitoes from
+// loadMosquitoes() are not restored.
+bool Community::restart(const Parameters* par) {
+    assert(canRestart(par));
+    _par = par;
+    for (Person* p: _people) p->updateParameters();
+    reset();
+
+    // people who withdrew to their homes have moved within their locations' lists of occupants
+    _occupancy.clear();
+    for (Person* p: _people) {
+        for (int t=0; t<(int) NUM_OF_TIME_PERIODS; t++) p->getLocation((TimePeriod) t)->addPerson(p, t);
+    }
+    _occupancy.pack();
+    for (Person* p: _people) {
+        ViremiaTally &vt = _viremiaTally[p->getID()];
+        vt = ViremiaTally();
+        for (int t=0; t<(int) NUM_OF_TIME_PERIODS; t++) vt.location[t] = p->getLocation((TimePeriod) t);
+    }
+
+    _nDay = 0;
+    _nRun = 0;                                                        // every stream starts afresh from par's seed
+    _fMosquitoCapacityMultiplier = 1.0;
+    _expectedEIP = -1;
+    _EIP_emu = -1;
+    _bNoSecondaryTransmission = false;
+
+    reseed(par->randomseed);
+    for (Location* loc: _location) {
+        loc->clearVectorControl();
+        if (!_sampleMosquitoCapacity(loc)) return false;
+    }
+    _bWeightedMosquitoMove = (_par->mosquitoMoveModel == "weighted");
+    _applyInitialImmunity();
+    return true;
 }
 
 
-Community::~Community() {
-    if (_people.size() > 0) { for (Person* p: _people) delete p; }
+// Writes everything about the community that changes during a simulation: the people's immune states and
+// whereabouts, the infected mosquitoes, the random streams and all of the schedules and tallies.  The tables that
+// are read from files are not written, so a snapshot is read back into a community built from the same files, with
+// the same tiles (see readSnapshot()).
+bool Community::writeSnapshot(ostream& os) const {
+    snapshot::write(os, (uint64_t) _people.size());
+    snapshot::write(os, (uint64_t) _location.size());
+    snapshot::write(os, (uint64_t) _tiles.size());
+
+    snapshot::write(os, _nDay);
+    snapshot::write(os, _nRun);
+    snapshot::write(os, _bNoSecondaryTransmission);
+    snapshot::write(os, _fMosquitoCapacityMultiplier);
+    snapshot::write(os, _expectedEIP);
+    snapshot::write(os, _EIP_emu);
+    snapshot::write(os, _nTalliedDays);
+    snapshot::write(os, _nActiveInfectionsDay);
+    snapshot::write(os, _bActiveInfectionsSorted);
+    _rng.write(os);
+
+    for (const Person* p: _people) p->write(os);
+    _occupancy.write(os);
+    for (const ViremiaTally &vt: _viremiaTally) {
+        vector<int> locationIDs;
+        for (const Location* loc: vt.location) locationIDs.push_back(loc ? loc->getID() : -1);
+        for (const Location* loc: vt.extraWorkDay) locationIDs.push_back(loc->getID());
+        snapshot::write(os, vt.viremic);
+        snapshot::write(os, vt.vaccinated);
+        snapshot::write(os, vt.serotype);
+        snapshot::write(os, locationIDs);
+    }
+    for (const Location* loc: _location) loc->write(os);
+
+    auto ids = [](const vector<Person*>& people) {
+        vector<int> v;
+        for (const Person* p: people) v.push_back(p->getID());
+        return v;
+    };
+    _isHot.write(os);
+    _diseaseEvents.write(os);
+    snapshot::write(os, ids(_activeInfections));
+    snapshot::write(os, ids(_changedPeople));
+    for (const vector<Person*> &bucket: _exposedQueue) snapshot::write(os, ids(bucket));
+    for (const vector< vector<int> >* tally: {&_nNumNewlyInfected, &_nNumNewlySymptomatic, &_nNumVaccinatedCases, &_nNumSevereCases}) {
+        snapshot::write(os, (uint32_t) tally->size());
+        for (const vector<int> &counts: *tally) snapshot::write(os, counts);
+    }
+    snapshot::write(os, (uint32_t) _delayedBirthdays.size());
+    for (const auto &day: _delayedBirthdays) {
+        vector<int> pairs;                                            // recipient, donor (-1 if none)
+        for (const auto &recip_donor: day.second) {
+            pairs.push_back(recip_donor.first->getID());
+            pairs.push_back(recip_donor.second ? recip_donor.second->getID() : -1);
+        }
+        snapshot::write(os, day.first);
+        snapshot::write(os, pairs);
+    }
+    snapshot::write(os, ids(vector<Person*>(_revaccinate_set.begin(), _revaccinate_set.end())));
+
+    for (const SpatialTile* tile: _tiles) {
+        tile->_streams.write(os);
+        tile->mosquitoes.write(os);
+        tile->infectiousMosquitoQueue.write(os);
+        tile->exposedMosquitoQueue.write(os);
+        tile->infectiousMosquitoCohorts.write(os);
+        tile->exposedMosquitoCohorts.write(os);
+    }
+    return (bool) os;
+}
+
+
+// Continues the simulation from a snapshot written by writeSnapshot().  Parameters are not part of the snapshot;
+// the community keeps the ones it was built (or restarted) with.  If false is returned, the community is unusable.
+bool Community::readSnapshot(istream& is) {
+    uint64_t nPeople = 0, nLocations = 0, nTiles = 0;
+    snapshot::read(is, nPeople);
+    snapshot::read(is, nLocations);
+    snapshot::read(is, nTiles);
+    if (not is or nPeople != _people.size() or nLocations != _location.size() or nTiles != _tiles.size()) {
+        cerr << "ERROR: snapshot is of a community with " << nPeople << " people, " << nLocations << " locations and "
+             << nTiles << " spatial tiles, but this one has " << _people.size() << ", " << _location.size() << " and "
+             << _tiles.size() << endl;
+        return false;
+    }
+    reset();                                                          // empties the schedules and queues
+
+    snapshot::read(is, _nDay);
+    snapshot::read(is, _nRun);
+    snapshot::read(is, _bNoSecondaryTransmission);
+    snapshot::read(is, _fMosquitoCapacityMultiplier);
+    snapshot::read(is, _expectedEIP);
+    snapshot::read(is, _EIP_emu);
+    snapshot::read(is, _nTalliedDays);
+    snapshot::read(is, _nActiveInfectionsDay);
+    snapshot::read(is, _bActiveInfectionsSorted);
+    _rng.read(is);
+
+    for (Person* p: _people) p->read(is);
+    _occupancy.read(is);
+    for (ViremiaTally &vt: _viremiaTally) {
+        vector<int> locationIDs;
+        snapshot::read(is, vt.viremic);
+        snapshot::read(is, vt.vaccinated);
+        snapshot::read(is, vt.serotype);
+        snapshot::read(is, locationIDs);
+        if (not is) break;
+        vt.extraWorkDay.clear();
+        for (unsigned int i = 0; i < locationIDs.size(); i++) {
+            Location* loc = (locationIDs[i] >= 0 and (unsigned) locationIDs[i] < _location.size()) ? _location[locationIDs[i]] : nullptr;
+            if (i < NUM_OF_TIME_PERIODS) {
+                vt.location[i] = loc;
+            } else if (loc) {
+                vt.extraWorkDay.push_back(loc);
+            }
+        }
+    }
+    for (Location* loc: _location) loc->read(is);
+    if (not is) {
+        cerr << "ERROR: snapshot is truncated or corrupt" << endl;
+        return false;
+    }
+
+    // people are written by ID; any other ID means a corrupt snapshot
+    bool valid = true;
+    auto readPeople = [&](vector<Person*>& people) {
+        vector<int> v;
+        snapshot::read(is, v);
+        people.clear();
+        for (int id: v) {
+            if (id < 0 or (unsigned) id >= _people.size()) { valid = false; return; }
+            people.push_back(_people[id]);
+        }
+    };
+    _isHot.read(is, _location);
+    _diseaseEvents.read(is, _people);
+    readPeople(_activeInfections);
+    for (Person* p: _activeInfections) {
+        if (p->getID() >= (int) _isActiveInfection.size()) _isActiveInfection.resize(p->getID() + 1, false);
+        _isActiveInfection[p->getID()] = true;
+    }
+    readPeople(_changedPeople);
+    for (Person* p: _changedPeople) {
+        if (p->getID() >= (int) _isChangedPerson.size()) _isChangedPerson.resize(p->getID() + 1, false);
+        _isChangedPerson[p->getID()] = true;
+    }
+    for (vector<Person*> &bucket: _exposedQueue) readPeople(bucket);
+    for (vector< vector<int> >* tally: {&_nNumNewlyInfected, &_nNumNewlySymptomatic, &_nNumVaccinatedCases, &_nNumSevereCases}) {
+        uint32_t n = 0;
+        snapshot::read(is, n);
+        if (n != tally->size()) { valid = false; break; }
+        for (vector<int> &counts: *tally) {
+            snapshot::read(is, counts);
+            counts.resize(_par->nRunLength + MAX_MOSQUITO_AGE, 0);    // the run length may differ from the snapshot's
+        }
+    }
+    uint32_t nDays = 0;
+    snapshot::read(is, nDays);
+    for (uint32_t d = 0; d < nDays and is and valid; d++) {
+        int day = 0;
+        vector<int> pairs;
+        snapshot::read(is, day);
+        snapshot::read(is, pairs);
+        for (unsigned int i = 0; i + 1 < pairs.size(); i += 2) {
+            if (pairs[i] < 0 or (unsigned) pairs[i] >= _people.size() or pairs[i+1] >= (int) _people.size()) { valid = false; break; }
+            _delayedBirthdays[day].insert(make_pair(_people[pairs[i]], pairs[i+1] >= 0 ? _people[pairs[i+1]] : nullptr));
+        }
+    }
+    vector<Person*> revaccinate;
+    readPeople(revaccinate);
+    _revaccinate_set.insert(revaccinate.begin(), revaccinate.end());
+
+    for (SpatialTile* tile: _tiles) {
+        tile->_streams.read(is);
+        tile->mosquitoes.read(is);
+        tile->infectiousMosquitoQueue.read(is);
+        tile->exposedMosquitoQueue.read(is);
+        tile->infectiousMosquitoCohorts.read(is);
+        tile->exposedMosquitoCohorts.read(is);
+    }
+    _exposureRound.clear();                                           // locations' biting weights are computed afresh
+
+    if (not is or not valid) {
+        cerr << "ERROR: snapshot is truncated or corrupt" << endl;
+        return false;
+    }
+    return true;
+}
+
+
+// Replaces what a snapshot of a simulation with snapshotPar set from those parameters with what this community's own
+// give, so that a simulation continued from it with other parameters uses them (see simulate_branches()).  If the
+// mosquito capacity or its distribution differ, every location's baseline capacity is sampled again, in ID order,
+// from the current SETUP_RNG stream; and secondary transmission is turned on or off.  The mosquitoes that are
+// already infected are kept.  The seasonal multiplier and EIP are the simulation's to set (see set_seasonality()).
+bool Community::adoptParameters(const Parameters* snapshotPar) {
+    if (_par->nDefaultMosquitoCapacity != snapshotPar->nDefaultMosquitoCapacity
+        or _par->eMosquitoDistribution != snapshotPar->eMosquitoDistribution) {
+        for (Location* loc: _location) {
+            if (!_sampleMosquitoCapacity(loc)) return false;
+        }
+    }
+    _bNoSecondaryTransmission = not _par->bSecondaryTransmission;
+    return true;
+}
+
+
+void Community::reseed(unsigned long int seed) {
+    _rng.reseed(seed);
+    for (SpatialTile* tile: _tiles) tile->reseed(seed);
+}
+
+
+// Creates a location for each of _structure's location attributes, with its own mosquito capacity.
+bool Community::_addLocations() {
+    for (const LocationAttributes& attributes: _structure->_locationAttributes) {
+        Location* loc = new Location(_location.size(), &attributes, &_location);
+        loc->setOccupancy(&_occupancy);
+        _location.push_back(loc);
+        if (!_sampleMosquitoCapacity(loc)) return false;
+    }
+    return true;
+}
 
-    Person::reset_ID_counter();
 
-    for (auto &e: _isHot) e.clear();
+// Creates a person for each of _structure's person attributes, at the locations they say, then indexes them.
+void Community::_addPeople() {
+    for (const PersonAttributes& attributes: _structure->_personAttributes) {
+        Person* p = new Person(this, _people.size(), &attributes, &_location);
+        _people.push_back(p);
+        for (int t=0; t<(int) NUM_OF_TIME_PERIODS; t++) p->getLocation((TimePeriod) t)->addPerson(p, t);
+    }
+    _indexPeople();
+}
+
+
+void Community::_applyInitialImmunity() {
+    for (auto &history: _structure->_initialImmunity) {
+        for (auto p: history.second) _people[history.first]->infect(p.second, p.first + _nDay);
+    }
+}
+
+
+// Lays out the occupants of each location, and indexes the people by age.  Called once everyone has been added.
+void Community::_indexPeople() {
+    _occupancy.pack();
+
+    if (_people.size() > 0) _viremiaTally.resize(_people.back()->getID() + 1);
+    for (Person* p: _people) {
+        for (int t=0; t<(int) NUM_OF_TIME_PERIODS; t++) _viremiaTally[p->getID()].location[t] = p->getLocation((TimePeriod) t);
+    }
+
+    _peopleByAge = _people;
+    sort(_peopleByAge.begin(), _peopleByAge.end(), PerPtrComp());
+
+    // keep track of all age cohorts for aging and mortality
+    _personAgeCohort.clear();
+    _personAgeCohort.resize(NUM_AGE_CLASSES, vector<Person*>(0));
+
+    for (Person* p: _people) {
+        int age = p->getAge();
+        assert(age<NUM_AGE_CLASSES);
+        _personAgeCohort[age].push_back(p);
+        _nPersonAgeCohortSizes[age]++;
+    }
+}
+
+
+Community::~Community() {
+    // the day flags and active infections refer to people, so must be emptied before the people are deleted
+    _isHot.clear();
+    _diseaseEvents.clear();
+    for (Person* p: _activeInfections) _isActiveInfection[p->getID()] = false;
+    _activeInfections.clear();
+    _nActiveInfectionsDay = INT_MIN;
+
+    if (_people.size() > 0) { for (Person* p: _people) delete p; }
 
     for (unsigned int i = 0; i < _location.size(); i++ ) delete _location[i];
     _location.clear();
@@ -107,11 +510,10 @@ Community::~Community() {
     for (unsigned int i = 0; i < _exposedQueue.size(); i++ ) _exposedQueue[i].clear();
     _exposedQueue.clear();
 
-    for (unsigned int i = 0; i < _infectiousMosquitoQueue.size(); i++ ) _infectiousMosquitoQueue[i].clear();
-    _infectiousMosquitoQueue.clear();
-
-    for (unsigned int i = 0; i < _exposedMosquitoQueue.size(); i++ ) _exposedMosquitoQueue[i].clear();
-    _exposedMosquitoQueue.clear();
+    for (SpatialTile* tile: _tiles) delete tile;
+    _tiles.clear();
+    for (gsl_rng* rng: _biteBlockRNG) gsl_rng_free(rng);
+    _biteBlockRNG.clear();
 
     for (unsigned int i = 0; i < _personAgeCohort.size(); i++ ) _personAgeCohort[i].clear();
     _personAgeCohort.clear();
@@ -166,25 +568,20 @@ bool Community::loadPopulation(string populationFilename, string immunityFilenam
 
         if (line >> id >> house >> sex >> age >> did) {// >> empstat) {
             if (did == -1) { did = house; }
-            Person* p = new Person();
-            _people.push_back(p);
-            p->setAge(age);
-            p->setSex((SexType) sex);
-            p->setHomeID(house);
-            p->setLocation(_location[house], HOME_MORNING);
-            p->setLocation(_location[did], WORK_DAY);
-            p->setLocation(_location[house], HOME_NIGHT);
-            _location[house]->addPerson(p, HOME_MORNING);
-            _location[did]->addPerson(p, WORK_DAY);
-            _location[house]->addPerson(p, HOME_NIGHT);
+            PersonAttributes attributes;
+            attributes.age = age;
+            attributes.sex = (SexType) sex;
+            attributes.homeID = house;
+            attributes.location[HOME_MORNING] = house;
+            attributes.location[WORK_DAY] = did;
+            attributes.location[HOME_NIGHT] = house;
+            _personAttributes.push_back(attributes);
             assert(age<NUM_AGE_CLASSES);
             agecounts[age]++;
         }
     }
     iss.close();
-
-    _peopleByAge = _people;
-    sort(_peopleByAge.begin(), _peopleByAge.end(), PerPtrComp());
+    _addPeople();                                                     // once _personAttributes will not be reallocated
 
     if (immunityFilename.length()>0) {
         ifstream immiss(immunityFilename.c_str());
@@ -224,7 +621,7 @@ bool Community::loadPopulation(string populationFilename, string immunityFilenam
                     }
                 }
                 sort(infection_history.begin(), infection_history.end());
-                for (auto p: infection_history) person->infect(p.second, p.first + _nDay);
+                _initialImmunity.push_back(make_pair(person->getID(), infection_history));
             } else if (parts.size() == 0) {
                 continue; // skipping blank line, or line that doesn't start with ints
             } else {
@@ -238,17 +635,7 @@ bool Community::loadPopulation(string populationFilename, string immunityFilenam
         }
         immiss.close();
     }
-
-    // keep track of all age cohorts for aging and mortality
-    _personAgeCohort.clear();
-    _personAgeCohort.resize(NUM_AGE_CLASSES, vector<Person*>(0));
-
-    for (Person* p: _people) {
-        int age = p->getAge();
-        assert(age<NUM_AGE_CLASSES);
-        _personAgeCohort[age].push_back(p);
-        _nPersonAgeCohortSizes[age]++;
-    }
+    _applyInitialImmunity();
 
     if (swapFilename == "") {
         _uniformSwap = true;
@@ -262,6 +649,7 @@ bool Community::loadPopulation(string populationFilename, string immunityFilenam
         int id1, id2;
         double prob;
         istringstream line;
+        _swapProbabilities.assign(_people.size(), vector<pair<int, double> >());
 
         while ( getline(iss, buffer) ) {
             line.clear();
@@ -269,7 +657,7 @@ bool Community::loadPopulation(string populationFilename, string immunityFilenam
 
             if (line >> id1 >> id2 >> prob) {
                 Person* person = getPersonByID(id1);
-                if (person) person->appendToSwapProbabilities(make_pair(id2, prob));
+                if (person) _swapProbabilities[person->getID()].push_back(make_pair(id2, prob));
             }
         }
         iss.close();
@@ -286,6 +674,7 @@ bool Community::loadLocations(string locationFilename,string networkFilename) {
         return false;
     }
     _location.clear();
+    _locationAttributes.clear();
 
     // This is a hack for backward compatibility.  Indices should start at zero.
     //Location* dummy = new Location();
@@ -305,9 +694,9 @@ bool Community::loadLocations(string locationFilename,string networkFilename) {
         line.str(buffer);
         // locid x y type arm center
         if (line >> locID >> locX >> locY >> locTypeStr >> trial_arm >> surveilled) {
-            if (locID != (signed) _location.size()) {
+            if (locID != (signed) _locationAttributes.size()) {
                 cerr << "ERROR: Location ID's must be sequential integers" << endl;
-                cerr << locID << " != " << _location.size() << endl;
+                cerr << locID << " != " << _locationAttributes.size() << endl;
                 return false;
             }
             const LocationType locType = (locTypeStr == "h") ? HOME : (locTypeStr == "w") ? WORK : (locTypeStr == "s") ? SCHOOL : NUM_OF_LOCATION_TYPES;
@@ -315,31 +704,17 @@ bool Community::loadLocations(string locationFilename,string networkFilename) {
                 cerr << "ERROR: Parsed unknown location type: " << locTypeStr << " from location file: " << locationFilename << endl;
                 return false;
             }
-            Location* newLoc = new Location();
-            newLoc->setID(locID);
-            newLoc->setX(locX);
-            newLoc->setY(locY);
-            newLoc->setType(locType);
-            newLoc->setTrialArm(trial_arm);
-            newLoc->setSurveilled(surveilled);
-
-            if (_par->eMosquitoDistribution==CONSTANT) {
-                // all houses have same number of mosquitoes
-                newLoc->setBaseMosquitoCapacity(_par->nDefaultMosquitoCapacity);
-            } else if (_par->eMosquitoDistribution==EXPONENTIAL) {
-                // exponential distribution of mosquitoes -dlc
-                // gsl takes the 1/lambda (== the expected value) as the parameter for the exp RNG
-                newLoc->setBaseMosquitoCapacity(gsl_ran_exponential(RNG, _par->nDefaultMosquitoCapacity));
-            } else {
-                cerr << "ERROR: Invalid mosquito distribution: " << _par->eMosquitoDistribution << endl;
-                cerr << "       Valid distributions include CONSTANT and EXPONENTIAL" << endl;
-                return false;
-            }
-
-            _location.push_back(newLoc);
+            LocationAttributes attributes;
+            attributes.ID = locID;
+            attributes.coord = make_pair(locX, locY);
+            attributes.type = locType;
+            attributes.trialArm = trial_arm;
+            attributes.surveilled = surveilled;
+            _locationAttributes.push_back(attributes);
         }
     }
     iss.close();
+    if (!_addLocations()) return false;                               // once _locationAttributes will not be reallocated
     //cerr << _location.size() << " locations" << endl;
 
     iss.open(networkFilename.c_str());
@@ -354,15 +729,108 @@ bool Community::loadLocations(string locationFilename,string networkFilename) {
         line.str(buffer);
         if (line >> locID1 >> locID2) { // data (non-header) line
             //      cerr << locID1 << " , " << locID2 << endl;
-            _location[locID1]->addNeighbor(_location[locID2]);            // should check for ID
-            _location[locID2]->addNeighbor(_location[locID1]);
+            _locationAttributes[locID1].addNeighbor(locID2);              // should check for ID
+            _locationAttributes[locID2].addNeighbor(locID1);
         }
     }
     iss.close();
 
+    _buildMovementTables();
+    _buildTiles();
+    return true;
+}
+
+
+// Recursive coordinate bisection: splits the locations in [first, last) into ntiles tiles, numbered from
+// firstTile, by cutting across the longer side of their bounding box.  Each side gets a share of the
+// locations proportional to its share of the tiles.
+static void bisect(vector<Location*>::iterator first, vector<Location*>::iterator last, unsigned int firstTile, unsigned int ntiles, vector<unsigned int>& tileOf) {
+    if (ntiles == 1) {
+        for (auto it = first; it != last; ++it) tileOf[(*it)->getID()] = firstTile;
+        return;
+    }
+    double xmin = (*first)->getX(), xmax = xmin, ymin = (*first)->getY(), ymax = ymin;
+    for (auto it = first; it != last; ++it) {
+        xmin = min(xmin, (*it)->getX()); xmax = max(xmax, (*it)->getX());
+        ymin = min(ymin, (*it)->getY()); ymax = max(ymax, (*it)->getY());
+    }
+    const bool alongX = (xmax - xmin >= ymax - ymin);
+    auto before = [alongX](const Location* a, const Location* b) {  // ties are broken by ID, so the cut is well-defined
+        const double ka = alongX ? a->getX() : a->getY();
+        const double kb = alongX ? b->getX() : b->getY();
+        return ka < kb or (ka == kb and a->getID() < b->getID());
+    };
+    const unsigned int lowTiles = ntiles / 2;
+    auto middle = first + (last - first) * lowTiles / ntiles;
+    nth_element(first, middle, last, before);
+    bisect(first, middle, firstTile, lowTiles, tileOf);
+    bisect(middle, last, firstTile + lowTiles, ntiles - lowTiles, tileOf);
+}
+
+
+// Partition locations into spatially contiguous tiles of (nearly) equal numbers of locations; see SpatialTile.
+// There are never more tiles than locations, so no tile is empty.
+void Community::_buildTiles() {
+    for (SpatialTile* tile: _tiles) delete tile;
+    _tiles.clear();
+    const unsigned int ntiles = max(1, min(_par->nSpatialTiles, (int) _location.size()));
+    _tileOf.assign(_location.size(), 0);
+    vector<Location*> locations(_location);
+    if (locations.size() > 0) bisect(locations.begin(), locations.end(), 0, ntiles, _tileOf);
+    for (unsigned int t = 0; t < ntiles; ++t) _tiles.push_back(new SpatialTile(t, ntiles, _location, &_rng));
+    for (Location* loc: _location) _tiles[_tileOf[loc->getID()]]->locations.push_back(loc);
+}
+
+
+bool Community::_sampleMosquitoCapacity(Location* loc) {
+    if (_par->eMosquitoDistribution==CONSTANT) {
+        // all houses have same number of mosquitoes
+        loc->setBaseMosquitoCapacity(_par->nDefaultMosquitoCapacity);
+    } else if (_par->eMosquitoDistribution==EXPONENTIAL) {
+        // exponential distribution of mosquitoes -dlc
+        // gsl takes the 1/lambda (== the expected value) as the parameter for the exp RNG
+        loc->setBaseMosquitoCapacity(gsl_ran_exponential(_rng.get(SETUP_RNG), _par->nDefaultMosquitoCapacity));
+    } else {
+        cerr << "ERROR: Invalid mosquito distribution: " << _par->eMosquitoDistribution << endl;
+        cerr << "       Valid distributions include CONSTANT and EXPONENTIAL" << endl;
+        return false;
+    }
     return true;
 }
 
+
+// Precompute, for each location, the cumulative probability of moving to each of its neighbors
+// under the weighted movement model.  The network and coordinates do not change during a run.
+void Community::_buildMovementTables() {
+    _neighborCDFStart.assign(_location.size() + 1, 0);
+    _neighborCDF.clear();
+    for (Location* pLoc: _location) {
+        const int degree = pLoc->getNumNeighbors();
+        const double x1 = pLoc->getX();
+        const double y1 = pLoc->getY();
+        vector<double> weights(degree, 0);
+        double sum_weights = 0.0;
+
+        // Prefer nearby neighbors
+        // Calculate distance-based weights to select each of the degree neighbors
+        for (int i=0; i<degree; i++) {
+            Location* loc2 = pLoc->getNeighbor(i);
+            double x2 = loc2->getX();
+            double y2 = loc2->getY();
+            double distance_squared = pow(x1-x2,2) + pow(y1-y2,2);
+            double w = 1.0 / distance_squared;
+            sum_weights += w;
+            weights[i] = w;
+        }
+        double cumulative = 0.0;
+        for (int i=0; i<degree; i++) {
+            cumulative += weights[i] / sum_weights;               // normalize prob
+            _neighborCDF.push_back(cumulative);
+        }
+        _neighborCDFStart[pLoc->getID() + 1] = _neighborCDF.size();
+    }
+}
+
 bool Community::loadMosquitoes(string moslocFilename, string mosFilename) {
     if (moslocFilename == "" and mosFilename == "") return true; // nothing to do
     assert(_location.size() > 0); // make sure loadLocations() was already called
@@ -395,13 +863,13 @@ bool Community::loadMosquitoes(string moslocFilename, string mosFilename) {
     ifstream iss_mos(mosFilename.c_str());
     if (!iss_mos) { cerr << "ERROR: " << mosFilename << " not found." << endl; return false; }
 
-    for (unsigned int i = 0; i < _exposedMosquitoQueue.size(); i++ ) _exposedMosquitoQueue[i].clear();
-    _exposedMosquitoQueue.clear();
-    _exposedMosquitoQueue.resize(MAX_MOSQUITO_AGE+1, vector<Mosquito*>(0));
-
-    for (unsigned int i = 0; i < _infectiousMosquitoQueue.size(); i++ ) _infectiousMosquitoQueue[i].clear();
-    _infectiousMosquitoQueue.clear();
-    _infectiousMosquitoQueue.resize(MAX_MOSQUITO_AGE+1, vector<Mosquito*>(0));
+    for (SpatialTile* tile: _tiles) {
+        tile->mosquitoes.clear();
+        tile->exposedMosquitoQueue.clear();
+        tile->infectiousMosquitoQueue.clear();
+        tile->exposedMosquitoCohorts.clear();
+        tile->infectiousMosquitoCohorts.clear();
+    }
 
     char queue;
     int sero, idx, ageInfd, ageInfs, ageDead;
@@ -418,14 +886,29 @@ bool Community::loadMosquitoes(string moslocFilename, string mosFilename) {
             }
             assert(sero < NUM_OF_SEROTYPES);
             Location* loc = _location[locID];
+            SpatialTile& tile = _tileAt(loc);
+            if (_par->eMosquitoModel == COMPARTMENTAL_MOSQUITOES) {
+                if (queue == 'e') {
+                    assert(idx < (signed) tile.exposedMosquitoCohorts.size());
+                    tile.exposedMosquitoCohorts[idx].emplace_back(locID, (Serotype) sero, ageDead - ageInfs, 1);
+                } else if (queue == 'i') {
+                    assert(idx < (signed) tile.infectiousMosquitoCohorts.size());
+                    tile.infectiousMosquitoCohorts[idx].emplace_back(locID, (Serotype) sero, 0, 1);
+                } else {
+                    cerr << "ERROR: unknown queue type: " << queue << endl;
+                    return false;
+                }
+                loc->addInfectedMosquito();
+                continue;
+            }
             RestoreMosquitoPars restorePars(loc, (Serotype) sero, ageInfd, ageInfs, ageDead);
-            Mosquito* m = new Mosquito(&restorePars);
+            const unsigned int m = tile.mosquitoes.restore(&restorePars);
             if (queue == 'e') {
-                assert(idx < (signed) _exposedMosquitoQueue.size());
-                _exposedMosquitoQueue[idx].push_back(m);
+                assert(idx < (signed) tile.exposedMosquitoQueue.size());
+                tile.exposedMosquitoQueue[idx].push_back(m);
             } else if (queue == 'i') {
-                assert(idx < (signed) _infectiousMosquitoQueue.size());
-                _infectiousMosquitoQueue[idx].push_back(m);
+                assert(idx < (signed) tile.infectiousMosquitoQueue.size());
+                tile.infectiousMosquitoQueue[idx].push_back(m);
             } else {
                 cerr << "ERROR: unknown queue type: " << queue << endl;
                 return false;
@@ -434,6 +917,10 @@ bool Community::loadMosquitoes(string moslocFilename, string mosFilename) {
     }
     iss_mos.close();
 
+    for (SpatialTile* tile: _tiles) {
+        for (unsigned int i = 0; i < tile->exposedMosquitoCohorts.size(); ++i) _mergeMosquitoCohorts(tile->exposedMosquitoCohorts[i]);
+        for (unsigned int i = 0; i < tile->infectiousMosquitoCohorts.size(); ++i) _mergeMosquitoCohorts(tile->infectiousMosquitoCohorts[i]);
+    }
     return true;
 }
 
@@ -478,6 +965,7 @@ bool Community::infect(int id, Serotype serotype, int day) {
 
     bool result =  person->infect(-1, serotype, day, 0);
     if (result) _nNumNewlyInfected[(int) serotype][_nDay]++;
+    _nTalliedDays = max(_nTalliedDays, (unsigned int) _nDay + 1);
     return result;
 }
 
@@ -494,10 +982,11 @@ void Community::vaccinate(CatchupVaccinationEvent cve) {
     for (Person* p: _personAgeCohort[cve.age]) {
         assert(p != NULL);
         if (!p->isVaccinated()
-            and cve.coverage > gsl_rng_uniform(RNG)
+            and cve.coverage > gsl_rng_uniform(_rng.get(VACCINATION_RNG))
             and p->isSeroEligible(_par->vaccineSeroConstraint, _par->seroTestFalsePos, _par->seroTestFalseNeg)
            ) {
             p->vaccinate(cve.simDay);
+            _updateViremiaTally(p);
             if (_par->vaccineBoosting or p->getNumVaccinations() < _par->numVaccineDoses) _revaccinate_set.insert(p);
         }
     }
@@ -517,10 +1006,12 @@ void Community::updateVaccination() {
         if (p->getNumVaccinations() < _par->numVaccineDoses and timeSinceLastVaccination >= _par->vaccineDoseInterval) {
             // multi-dose vaccination
             p->vaccinate(_nDay);
+            _updateViremiaTally(p);
             if (p->getNumVaccinations() == _par->numVaccineDoses) _revaccinate_set.erase(p); // we're done
         } else if (_par->vaccineBoosting and timeSinceLastVaccination >= _par->vaccineBoostingInterval) {
             // booster dose
             p->vaccinate(_nDay);
+            _updateViremiaTally(p);
         }
     }
 }
@@ -534,98 +1025,164 @@ void Community::targetVaccination(Person* p) {
         and p->isSeroEligible(_par->vaccineSeroConstraint, _par->seroTestFalsePos, _par->seroTestFalseNeg)
        ) {
         // standard vaccination of target age; vaccinate w/ probability = coverage
-        if (gsl_rng_uniform(RNG) < _par->vaccineTargetCoverage) p->vaccinate(_nDay);
+        if (gsl_rng_uniform(_rng.get(VACCINATION_RNG)) < _par->vaccineTargetCoverage) {
+            p->vaccinate(_nDay);
+            _updateViremiaTally(p);
+        }
         if (_par->vaccineBoosting or _par->numVaccineDoses > 1) _revaccinate_set.insert(p);
     }
 }
 
 
 // returns number of days mosquito has left to live
-void Community::attemptToAddMosquito(Location* p, Serotype serotype, int nInfectedByID, double prob_infecting_bite) {
-    int eip = (int) (getEIP() + 0.5);
+void Community::attemptToAddMosquito(Location* p, Serotype serotype, double prob_infecting_bite) {
+    SpatialTile& tile = _tileAt(p);
+    const gsl_rng* rng = tile.getRNG(BITING_RNG);
+    int eip = (int) (getEIP(rng) + 0.5);
 
     // It doesn't make sense to have an EIP that is greater than the mosquitoes lifespan
     // Truncating also makes vector sizing more straightforward
     eip = eip > MAX_MOSQUITO_AGE ? MAX_MOSQUITO_AGE : eip;
-    Mosquito* m = new Mosquito(p, serotype, nInfectedByID, eip, prob_infecting_bite);
-    int daysleft = m->getAgeDeath() - m->getAgeInfected();
+    if (_par->eMosquitoModel == COMPARTMENTAL_MOSQUITOES) {
+        int ageInfected, ageDeath;
+        MosquitoPool::sampleAges(rng, prob_infecting_bite, ageInfected, ageDeath);
+        const int daysinfectious = ageDeath - ageInfected - eip;
+        if (daysinfectious > 0) {                                     // otherwise dies before infectious
+            p->addInfectedMosquito();
+            if (eip == 0) {
+                tile.infectiousMosquitoCohorts[daysinfectious].emplace_back(p->getID(), serotype, 0, 1);
+            } else {
+                tile.exposedMosquitoCohorts[eip].emplace_back(p->getID(), serotype, daysinfectious, 1);
+            }
+        }
+        return;                                                       // new cohorts are merged when mosquitoes move
+    }
+    const unsigned int m = tile.mosquitoes.create(rng, p, serotype, eip, prob_infecting_bite);
+    int daysleft = tile.mosquitoes.getAgeDeath(m) - tile.mosquitoes.getAgeInfected(m);
     int daysinfectious = daysleft - eip;
     if (daysinfectious<=0) {
         // dies before infectious
-        delete m;
+        tile.mosquitoes.kill(m);
     } else {
         if (eip == 0) {
             // infectious immediately -- unlikely, but supported
             // we don't push onto index 0, because we're at the end of the day already;
             // this mosquito would be destroyed before being allowed to transmit
-            _infectiousMosquitoQueue[daysinfectious].push_back(m);
+            tile.infectiousMosquitoQueue[daysinfectious].push_back(m);
         } else {
             // more typically, add mosquito to latency queue
-            _exposedMosquitoQueue[eip].push_back(m);
+            tile.exposedMosquitoQueue[eip].push_back(m);
         }
     }
     return;
 }
 
 
-void Community::mosquitoFilter(vector<Mosquito*>& mosquitoes, const double survival_prob) {
+void Community::mosquitoFilter(SpatialTile& tile, vector<unsigned int>& mosquitoes, const double survival_prob) {
     if (survival_prob >= 1.0) return;
     const unsigned int nmos = mosquitoes.size();
     if (nmos == 0) return;
-    gsl_ran_shuffle(RNG, mosquitoes.data(), nmos, sizeof(Mosquito*));
-    const int survivors = gsl_ran_binomial(RNG, survival_prob, nmos);
-    for (unsigned int m = survivors; m<mosquitoes.size(); ++m) delete mosquitoes[m];
+    gsl_ran_shuffle(tile.getRNG(MOSQUITO_SURVIVAL_RNG), mosquitoes.data(), nmos, sizeof(unsigned int));
+    const int survivors = gsl_ran_binomial(tile.getRNG(MOSQUITO_SURVIVAL_RNG), survival_prob, nmos);
+    for (unsigned int m = survivors; m<mosquitoes.size(); ++m) tile.mosquitoes.kill(mosquitoes[m]);
     mosquitoes.resize(survivors);
 }
 
 
+void Community::mosquitoFilter(SpatialTile& tile, vector<MosquitoCohort>& cohorts, const double survival_prob) {
+    if (survival_prob >= 1.0) return;
+    unsigned int survivors = 0;
+    for (MosquitoCohort &c: cohorts) {
+        if (_cohortSurvival(tile.getRNG(MOSQUITO_SURVIVAL_RNG), c, survival_prob)) cohorts[survivors++] = c;
+    }
+    cohorts.erase(cohorts.begin() + survivors, cohorts.end());
+}
+
+
+// each mosquito in cohort c survives with probability survival_prob; returns whether any do
+bool Community::_cohortSurvival(const gsl_rng* rng, MosquitoCohort &c, const double survival_prob) {
+    const int survivors = gsl_ran_binomial(rng, survival_prob, c.count);
+    _location[c.locationID]->removeInfectedMosquitoes(c.count - survivors);
+    c.count = survivors;
+    return survivors > 0;
+}
+
+
+// combine cohorts with the same location, serotype and days infectious, and drop empty ones
+void Community::_mergeMosquitoCohorts(vector<MosquitoCohort>& cohorts) {
+    sort(cohorts.begin(), cohorts.end());
+    unsigned int n = 0;
+    for (unsigned int i = 0; i < cohorts.size(); ++i) {
+        if (cohorts[i].count == 0) continue;
+        if (n > 0 and not (cohorts[n-1] < cohorts[i])) {
+            cohorts[n-1].count += cohorts[i].count;
+        } else {
+            cohorts[n++] = cohorts[i];
+        }
+    }
+    cohorts.erase(cohorts.begin() + n, cohorts.end());
+}
+
+
 void Community::applyMosquitoMultiplier(double current) {
     const double prev = getMosquitoMultiplier();
     setMosquitoMultiplier(current);
     if (current < prev) {
         const double survival_prob = current/prev;
-        for (unsigned int day = 0; day < _exposedMosquitoQueue.size(); ++day) mosquitoFilter(_exposedMosquitoQueue[day], survival_prob);
-        for (unsigned int day = 0; day < _infectiousMosquitoQueue.size(); ++day) mosquitoFilter(_infectiousMosquitoQueue[day], survival_prob);
+        _forEachTile([&](SpatialTile& tile) {
+            for (unsigned int day = 0; day < tile.exposedMosquitoQueue.size(); ++day) mosquitoFilter(tile, tile.exposedMosquitoQueue[day], survival_prob);
+            for (unsigned int day = 0; day < tile.infectiousMosquitoQueue.size(); ++day) mosquitoFilter(tile, tile.infectiousMosquitoQueue[day], survival_prob);
+            for (unsigned int day = 0; day < tile.exposedMosquitoCohorts.size(); ++day) mosquitoFilter(tile, tile.exposedMosquitoCohorts[day], survival_prob);
+            for (unsigned int day = 0; day < tile.infectiousMosquitoCohorts.size(); ++day) mosquitoFilter(tile, tile.infectiousMosquitoCohorts[day], survival_prob);
+        });
     }
 }
 
 
 void Community::applyVectorControl() {
-    for (Location* loc: _location) loc->updateVectorControlQueue(_nDay); // make sure proper VC is active for tomorrow -- must be at end
-
-    vector<Mosquito*> swap;
-    for (unsigned int day = 0; day < _exposedMosquitoQueue.size(); ++day) {
-        for (Mosquito* m: _exposedMosquitoQueue[day]) {
-            const float vc_rho = m->getLocation()->getCurrentVectorControlDailyMortality(_nDay);
-            if (vc_rho > 0 and gsl_rng_uniform(RNG) < vc_rho) {
-                delete m;
-            } else {
-                swap.push_back(m);
-            }
+    _forEachTile([&](SpatialTile& tile) {
+        for (Location* loc: tile.locations) loc->updateVectorControlQueue(_nDay); // make sure proper VC is active for tomorrow -- must be at end
+
+        for (unsigned int day = 0; day < tile.exposedMosquitoQueue.size(); ++day) _vectorControlFilter(tile, tile.exposedMosquitoQueue[day]);
+        for (unsigned int day = 0; day < tile.infectiousMosquitoQueue.size(); ++day) _vectorControlFilter(tile, tile.infectiousMosquitoQueue[day]);
+        for (unsigned int day = 0; day < tile.exposedMosquitoCohorts.size(); ++day) _vectorControlFilter(tile, tile.exposedMosquitoCohorts[day]);
+        for (unsigned int day = 0; day < tile.infectiousMosquitoCohorts.size(); ++day) _vectorControlFilter(tile, tile.infectiousMosquitoCohorts[day]);
+    });
+}
+
+
+// kill mosquitoes subject to vector control, compacting survivors in place (preserves order)
+void Community::_vectorControlFilter(SpatialTile& tile, vector<unsigned int> &mosquitoes) {
+    unsigned int survivors = 0;
+    for (unsigned int m: mosquitoes) {
+        const float vc_rho = tile.mosquitoes.getLocation(m)->getCurrentVectorControlDailyMortality(_nDay);
+        if (vc_rho > 0 and gsl_rng_uniform(tile.getRNG(VECTOR_CONTROL_RNG)) < vc_rho) {
+            tile.mosquitoes.kill(m);
+        } else {
+            mosquitoes[survivors++] = m;
         }
-        _exposedMosquitoQueue[day] = swap;
-        swap.clear();
     }
+    mosquitoes.resize(survivors);
+}
 
-    for (unsigned int day = 0; day < _infectiousMosquitoQueue.size(); ++day) {
-        for (Mosquito* m: _infectiousMosquitoQueue[day]) {
-            const float vc_rho = m->getLocation()->getCurrentVectorControlDailyMortality(_nDay);
-            if (vc_rho > 0 and gsl_rng_uniform(RNG) < vc_rho) {
-                delete m;
-            } else {
-                swap.push_back(m);
-            }
-        }
-        _infectiousMosquitoQueue[day] = swap;
-        swap.clear();
+
+void Community::_vectorControlFilter(SpatialTile& tile, vector<MosquitoCohort> &cohorts) {
+    unsigned int survivors = 0;
+    for (MosquitoCohort &c: cohorts) {
+        const float vc_rho = _location[c.locationID]->getCurrentVectorControlDailyMortality(_nDay);
+        if (vc_rho <= 0 or _cohortSurvival(tile.getRNG(VECTOR_CONTROL_RNG), c, 1.0 - vc_rho)) cohorts[survivors++] = c;
     }
+    cohorts.erase(cohorts.begin() + survivors, cohorts.end());
 }
 
 
 int Community::getNumInfectiousMosquitoes() {
     int count = 0;
-    for (unsigned int i=0; i<_infectiousMosquitoQueue.size(); i++) {
-        count += _infectiousMosquitoQueue[i].size();
+    for (const SpatialTile* tile: _tiles) {
+        for (unsigned int i=0; i<tile->infectiousMosquitoQueue.size(); i++) {
+            count += tile->infectiousMosquitoQueue[i].size();
+            for (const MosquitoCohort &c: tile->infectiousMosquitoCohorts[i]) count += c.count;
+        }
     }
     return count;
 }
@@ -633,89 +1190,132 @@ int Community::getNumInfectiousMosquitoes() {
 
 int Community::getNumExposedMosquitoes() {
     int count = 0;
-    for (unsigned int i=0; i<_exposedMosquitoQueue.size(); i++) {
-        count += _exposedMosquitoQueue[i].size();
+    for (const SpatialTile* tile: _tiles) {
+        for (unsigned int i=0; i<tile->exposedMosquitoQueue.size(); i++) {
+            count += tile->exposedMosquitoQueue[i].size();
+            for (const MosquitoCohort &c: tile->exposedMosquitoCohorts[i]) count += c.count;
+        }
     }
     return count;
 }
 
 
-Mosquito* Community::getInfectiousMosquito(int n) {
-    for (unsigned int i=0; i<_infectiousMosquitoQueue.size(); i++) {
-        int bin_size = _infectiousMosquitoQueue[i].size();
-        if (n >= bin_size) {
-            n -= bin_size;
-        } else {
-            return _infectiousMosquitoQueue[i][n];
+// where mosquito m (of tile) is after today's movement; possibly where it already was
+Location* Community::moveMosquito(SpatialTile& tile, unsigned int m) {
+    const gsl_rng* rng = tile.getRNG(MOSQUITO_MOVEMENT_RNG);
+    Location* pLoc = tile.mosquitoes.getLocation(m);
+    double r = gsl_rng_uniform(rng);
+    if (r<_par->fMosquitoMove) {
+        if (r<_par->fMosquitoTeleport) {                // teleport
+            int locID = gsl_rng_uniform_int(rng,_location.size());
+            return _location[locID];
+        } else {                                        // move to neighbor
+            int degree = pLoc->getNumNeighbors();
+            if (degree == 0) return pLoc;               // movement isn't possible; no neighbors exist
+            int neighbor=0;                             // neighbor is an index
+
+            if (_bWeightedMosquitoMove) {                // Prefer nearby neighbors; see _buildMovementTables()
+                const double r2 = gsl_rng_uniform(rng);
+                const double* cdf = &_structure->_neighborCDF[_structure->_neighborCDFStart[pLoc->getID()]];
+                neighbor = upper_bound(cdf, cdf + degree - 1, r2) - cdf; // the last neighbor takes any rounding shortfall
+            } else {                                    // Alternatively, ignore distances when choosing destination
+                if (degree>0) {
+                    neighbor = gsl_rng_uniform_int(rng,pLoc->getNumNeighbors());
+                }
+            }
+
+            return pLoc->getNeighbor(neighbor);
         }
     }
-    return NULL;
+    return pLoc;
 }
 
 
-Mosquito* Community::getExposedMosquito(int n) {
-    for (unsigned int i=0; i<_exposedMosquitoQueue.size(); i++) {
-        int bin_size = _exposedMosquitoQueue[i].size();
-        if (n >= bin_size) {
-            n -= bin_size;
+// moves the mosquitoes in one of tile's queue buckets; mosquitoes that leave the tile are removed from the
+// bucket and put in the tile's outbox
+void Community::moveMosquitoes(SpatialTile& tile, vector<unsigned int>& mosquitoes, bool infectious, unsigned int day) {
+    MosquitoPool& pool = tile.mosquitoes;
+    unsigned int stay = 0;                                            // mosquitoes still in the tile, compacted in place
+    for (unsigned int m: mosquitoes) {
+        Location* dest = moveMosquito(tile, m);
+        if (_tileOf[dest->getID()] == tile.id) {
+            if (dest != pool.getLocation(m)) pool.updateLocation(m, dest);
+            mosquitoes[stay++] = m;
         } else {
-            return _exposedMosquitoQueue[i][n];
+            RestoreMosquitoPars migrant(dest, pool.getSerotype(m), pool.getAgeInfected(m), pool.getAgeInfectious(m), pool.getAgeDeath(m), pool.getID(m));
+            tile.outbox.emplace_back(infectious, day, migrant);
+            pool.kill(m);
         }
     }
-    return NULL;
+    mosquitoes.resize(stay);
 }
 
 
-void Community::moveMosquito(Mosquito* m) {
-    double r = gsl_rng_uniform(RNG);
-    if (r<_par->fMosquitoMove) {
-        if (r<_par->fMosquitoTeleport) {                // teleport
-            int locID = gsl_rng_uniform_int(RNG,_location.size());
-            m->updateLocation(_location[locID]);
-        } else {                                        // move to neighbor
-            Location* pLoc = m->getLocation();
-            double x1 = pLoc->getX();
-            double y1 = pLoc->getY();
+// Binomial counterpart of moveMosquito(): splits each cohort into mosquitoes that stay, teleport, or
+// move to each neighbor.  Mosquitoes that move arrive as new cohorts, which are merged at the end
+// (or, if they leave the tile, go to the tile's outbox).
+void Community::moveMosquitoes(SpatialTile& tile, vector<MosquitoCohort>& cohorts, bool infectious, unsigned int day) {
+    const gsl_rng* rng = tile.getRNG(MOSQUITO_MOVEMENT_RNG);
+    const double teleport = min(_par->fMosquitoTeleport, _par->fMosquitoMove);
+    const double move = (teleport < 1.0) ? (_par->fMosquitoMove - teleport)/(1.0 - teleport) : 0.0; // given no teleport
+    auto arrive = [&](int locID, const MosquitoCohort& c, int k) {
+        if (_tileOf[locID] == tile.id) {
+            cohorts.emplace_back(locID, c.serotype, c.daysInfectious, k);
+            _location[locID]->addInfectedMosquitoes(k);
+        } else {
+            tile.outbox.emplace_back(infectious, day, MosquitoCohort(locID, c.serotype, c.daysInfectious, k));
+        }
+    };
+    const unsigned int n = cohorts.size();                            // arriving cohorts are not moved again
+    for (unsigned int i = 0; i < n; ++i) {
+        const MosquitoCohort c = cohorts[i];
+        Location* pLoc = _location[c.locationID];
+        int stay = c.count;
+
+        const int teleporters = (teleport > 0.0) ? gsl_ran_binomial(rng, teleport, stay) : 0;
+        for (int k = 0; k < teleporters; ++k) arrive(gsl_rng_uniform_int(rng,_location.size()), c, 1);
+        stay -= teleporters;
+
+        const int degree = pLoc->getNumNeighbors();                   // movement isn't possible if no neighbors exist
+        int movers = (degree > 0 and move > 0.0) ? gsl_ran_binomial(rng, move, stay) : 0;
+        stay -= movers;
+        double remaining = 1.0;                                       // probability not yet assigned to a neighbor
+        const double* cdf = _bWeightedMosquitoMove ? &_structure->_neighborCDF[_structure->_neighborCDFStart[pLoc->getID()]] : nullptr;
+        for (int j = 0; j < degree and movers > 0; ++j) {
+            const double p = cdf ? cdf[j] - (j > 0 ? cdf[j-1] : 0.0) : 1.0/degree;
+            const int k = (j == degree-1 or p >= remaining) ? movers : gsl_ran_binomial(rng, p/remaining, movers);
+            remaining -= p;
+            if (k > 0) {
+                arrive(pLoc->getNeighbor(j)->getID(), c, k);
+                movers -= k;
+            }
+        }
 
-            int degree = pLoc->getNumNeighbors();
-            if (degree == 0) return;                    // movement isn't possible; no neighbors exist
-            int neighbor=0;                             // neighbor is an index
+        pLoc->removeInfectedMosquitoes(c.count - stay);
+        cohorts[i].count = stay;
+    }
+    _mergeMosquitoCohorts(cohorts);
+}
 
-            if (_par->mosquitoMoveModel == "weighted") {
-                vector<double> weights(degree, 0);
-                double sum_weights = 0.0;
-
-                // Prefer nearby neighbors
-                // Calculate distance-based weights to select each of the degree neighbors
-                for (int i=0; i<degree; i++) {
-                    Location* loc2 = pLoc->getNeighbor(i);
-                    double x2 = loc2->getX();
-                    double y2 = loc2->getY();
-                    double distance_squared = pow(x1-x2,2) + pow(y1-y2,2);
-                    double w = 1.0 / distance_squared;
-                    sum_weights += w;
-                    weights[i] = w;
-                }
-                double r2 = gsl_rng_uniform(RNG);
-                neighbor = degree-1;                    // neighbor is (still) an index
-                int idx;
-                for ( idx = 0; idx < degree - 1; idx++ ) {
-                    weights[idx] /= sum_weights;        // normalize prob
-                    if ( r2 < weights[idx] ) {
-                        break;
-                    } else {
-                        r2 -= weights[idx];
-                    }
-                }
-                neighbor = idx;
-            } else {                                    // Alternatively, ignore distances when choosing destination
-                if (degree>0) {
-                    neighbor = gsl_rng_uniform_int(RNG,pLoc->getNumNeighbors());
-                }
-            }
 
-            m->updateLocation(pLoc->getNeighbor(neighbor));
+// deliver the mosquitoes that moved to another tile today.  Tiles' outboxes are emptied in tile order, so
+// where arrivals are queued does not depend on which tile finished moving first.  Arriving cohorts are
+// merged with the others the next time they move.
+void Community::_receiveMigrants() {
+    for (SpatialTile* from: _tiles) {
+        for (MosquitoMigrant &migrant: from->outbox) {
+            if (migrant.cohort.count > 0) {
+                const MosquitoCohort &c = migrant.cohort;
+                SpatialTile& to = *_tiles[_tileOf[c.locationID]];
+                (migrant.infectious ? to.infectiousMosquitoCohorts : to.exposedMosquitoCohorts)[migrant.day].push_back(c);
+                _location[c.locationID]->addInfectedMosquitoes(c.count);
+            } else {
+                SpatialTile& to = _tileAt(migrant.mosquito.location);
+                const unsigned int m = to.mosquitoes.restore(&migrant.mosquito);
+                (migrant.infectious ? to.infectiousMosquitoQueue : to.exposedMosquitoQueue)[migrant.day].push_back(m);
+            }
         }
+        from->outbox.clear();
     }
 }
 
@@ -729,12 +1329,12 @@ void Community::_processBirthday(Person* p) {
         // For people of age x, copy immune status from people of age x-1
         // TODO: this may not be safe, if there are age gaps, i.e. people of age N with no one of age N-1
         const int donor_age = p->getAge() - 1;
-        int r = gsl_rng_uniform_int(RNG,_nPersonAgeCohortSizes[donor_age]);
+        int r = gsl_rng_uniform_int(_rng.get(BIRTHDAY_RNG),_nPersonAgeCohortSizes[donor_age]);
         donor = _personAgeCohort[donor_age][r];
     } else {
         // Same as above, but use weighted sampling based on swap probs from file
-        double r = gsl_rng_uniform(RNG);
-        const vector<pair<int, double> >& swap_probs = p->getSwapProbabilities();
+        double r = gsl_rng_uniform(_rng.get(BIRTHDAY_RNG));
+        const vector<pair<int, double> >& swap_probs = _structure->_swapProbabilities[p->getID()];
         int n;
         for (n = 0; n < (signed) swap_probs.size() - 1; n++) {
             if (r < swap_probs[n].second) {
@@ -767,6 +1367,8 @@ void Community::_processBirthday(Person* p) {
                 }
             }
         }
+        _updateViremiaTally(p);
+        flagInfectedPerson(p);
     }
 }
 
@@ -782,6 +1384,8 @@ void Community::_swapIfNeitherInfected(Person* p, Person* donor) {
         } else {
             p->resetImmunity();
         }
+        _updateViremiaTally(p);
+        flagInfectedPerson(p);
     } else {
         if (_delayedBirthdays.count(process_date) == 0) _delayedBirthdays[process_date] = set<pair< Person*, Person*> >();
         _delayedBirthdays[process_date].insert(make_pair(p, donor));
@@ -821,8 +1425,9 @@ void Community::swapImmuneStates() {
 
 
 void Community::updateDiseaseStatus() {
-    for (Person* p: _people) {
-        if (p->getNumNaturalInfections() == 0) continue;
+    _compactActiveInfections();
+    for (Person* p: _diseaseEvents.get(_nDay)) {                      // only people with something scheduled for today
+        if (p->getNumNaturalInfections() == 0) continue;              // infection history was reset at a birthday swap
         if (p->getSymptomTime()==_nDay) {                              // started showing symptoms today
             _nNumNewlySymptomatic[(int) p->getSerotype()][_nDay]++;
             if (p->isVaccinated()) {
@@ -834,11 +1439,17 @@ void Community::updateDiseaseStatus() {
         }
         if (p->getWithdrawnTime()==_nDay) {                            // started withdrawing
             p->getLocation(HOME_MORNING)->addPerson(p,WORK_DAY);       // stays at home at mid-day
-            p->getLocation(WORK_DAY)->removePerson(p,WORK_DAY);        // does not go to work
+            _addViremiaTally(p, p->getLocation(HOME_MORNING));
+            if (p->getLocation(WORK_DAY)->removePerson(p,WORK_DAY)) {  // does not go to work
+                _removeViremiaTally(p, p->getLocation(WORK_DAY));
+            }
         } else if (p->isWithdrawn(_nDay-1) and
         p->getRecoveryTime()==_nDay) {                                 // just stopped withdrawing
             p->getLocation(WORK_DAY)->addPerson(p,WORK_DAY);           // goes back to work
-            p->getLocation(HOME_MORNING)->removePerson(p,WORK_DAY);    // stops staying at home
+            _addViremiaTally(p, p->getLocation(WORK_DAY));
+            if (p->getLocation(HOME_MORNING)->removePerson(p,WORK_DAY)) { // stops staying at home
+                _removeViremiaTally(p, p->getLocation(HOME_MORNING));
+            }
         }
     }
     return;
@@ -846,113 +1457,401 @@ void Community::updateDiseaseStatus() {
 
 
 void Community::flagInfectedLocation(Location* _pLoc, int day) {
-    if (day < _par->nRunLength) _isHot[day].insert(_pLoc);
+    if (day < _par->nRunLength) _isHot.insert(_pLoc, day);
+}
+
+
+void Community::flagNewInfection(Person* p) {
+    // Flag locations with (non-historical) infections, so that we know to look there for human->mosquito transmission
+    // Negative days are historical (pre-simulation) events, and thus we don't care about modeling transmission
+    for (int day = std::max(p->getInfectiousTime(), 0); day < p->getRecoveryTime(); day++) {
+        for (int t=0; t<(int) NUM_OF_TIME_PERIODS; t++) {
+            flagInfectedLocation(p->getLocation((TimePeriod) t), day);
+        }
+    }
+    // Likewise track this infection (active infections, location viremia tallies)
+    flagInfectedPerson(p);
+}
+
+
+void Community::flagInfectedPerson(Person* p) {
+    _markChanged(p);
+    if (p->getNumNaturalInfections() == 0) return;
+    const int recoveryTime = p->getRecoveryTime();
+    if (recoveryTime < 0) return;                                     // historical infection, resolved before the simulation
+
+    const unsigned int id = p->getID();
+    if (id >= _isActiveInfection.size()) _isActiveInfection.resize(id + 1, false);
+    if (not _isActiveInfection[id]) {
+        _isActiveInfection[id] = true;
+        if (_activeInfections.size() > 0 and _activeInfections.back()->getID() > p->getID()) _bActiveInfectionsSorted = false;
+        _activeInfections.push_back(p);
+    }
+
+    // schedule p's disease-status changes: viremia starts, symptoms start, withdrawal to home, and
+    // recovery (return to work, viremia ends).  Days before the simulation started are already past.
+    const int events[] = { std::max(p->getInfectiousTime(), 0), p->getSymptomTime(), p->getWithdrawnTime(), recoveryTime };
+    for (int day: events) {
+        if (day >= 0 and day < _par->nRunLength) _diseaseEvents.insert(p, day);
+    }
+}
+
+
+const vector<Person*>& Community::getActiveInfections() {
+    if (not _bActiveInfectionsSorted) {
+        sort(_activeInfections.begin(), _activeInfections.end(), PerIDComp());
+        _bActiveInfectionsSorted = true;
+    }
+    return _activeInfections;
+}
+
+
+// drop people who recovered before today; recoveries today still need to be processed
+void Community::_compactActiveInfections() {
+    unsigned int n = 0;
+    for (Person* p: _activeInfections) {
+        if (p->getNumNaturalInfections() > 0 and p->getRecoveryTime() >= _nDay) {
+            _activeInfections[n++] = p;
+        } else {
+            _isActiveInfection[p->getID()] = false;
+        }
+    }
+    _activeInfections.resize(n);
+    _nActiveInfectionsDay = _nDay;
+}
+
+
+// every change to a person's infections or vaccinations is followed by flagInfectedPerson() or
+// _updateViremiaTally(), which note that reset() has to restore them
+void Community::_markChanged(Person* p) {
+    const unsigned int id = p->getID();
+    if (id >= _isChangedPerson.size()) _isChangedPerson.resize(id + 1, false);
+    if (not _isChangedPerson[id]) {
+        _isChangedPerson[id] = true;
+        _changedPeople.push_back(p);
+    }
+}
+
+
+// bring the viremia tallies at p's locations up to date with p's status today
+void Community::_updateViremiaTally(Person* p) {
+    _markChanged(p);
+    ViremiaTally &vt = _viremiaTally[p->getID()];
+    const bool viremic = p->isViremic(_nDay);
+    const bool vaccinated = viremic and p->isVaccinated();
+    const Serotype serotype = viremic ? p->getSerotype() : NULL_SEROTYPE;
+    if (viremic == vt.viremic and vaccinated == vt.vaccinated and serotype == vt.serotype) return;
+
+    for (int t=0; t<(int) NUM_OF_TIME_PERIODS; t++) {
+        if (not vt.location[t]) continue;
+        if (vt.viremic) vt.location[t]->removeViremicPerson((TimePeriod) t, vt.vaccinated, vt.serotype);
+        if (viremic) vt.location[t]->addViremicPerson((TimePeriod) t, vaccinated, serotype);
+    }
+    for (Location* loc: vt.extraWorkDay) {
+        if (vt.viremic) loc->removeViremicPerson(WORK_DAY, vt.vaccinated, vt.serotype);
+        if (viremic) loc->addViremicPerson(WORK_DAY, vaccinated, serotype);
+    }
+    vt.viremic = viremic;
+    vt.vaccinated = vaccinated;
+    vt.serotype = serotype;
+}
+
+
+// p has been added to loc's WORK_DAY list
+void Community::_addViremiaTally(Person* p, Location* loc) {
+    ViremiaTally &vt = _viremiaTally[p->getID()];
+    if (vt.location[WORK_DAY]) {
+        vt.extraWorkDay.push_back(loc);
+    } else {
+        vt.location[WORK_DAY] = loc;
+    }
+    if (vt.viremic) loc->addViremicPerson(WORK_DAY, vt.vaccinated, vt.serotype);
+}
+
+
+// p has been removed from loc's WORK_DAY list
+void Community::_removeViremiaTally(Person* p, Location* loc) {
+    ViremiaTally &vt = _viremiaTally[p->getID()];
+    if (vt.location[WORK_DAY] == loc) {
+        if (vt.extraWorkDay.size() > 0) {
+            vt.location[WORK_DAY] = vt.extraWorkDay.back();
+            vt.extraWorkDay.pop_back();
+        } else {
+            vt.location[WORK_DAY] = nullptr;
+        }
+    } else {
+        auto it = find(vt.extraWorkDay.begin(), vt.extraWorkDay.end(), loc);
+        assert(it != vt.extraWorkDay.end());
+        vt.extraWorkDay.erase(it);
+    }
+    if (vt.viremic) loc->removeViremicPerson(WORK_DAY, vt.vaccinated, vt.serotype);
 }
 
 
 void Community::mosquitoToHumanTransmission() {
-    for(unsigned int i=0; i<_infectiousMosquitoQueue.size(); i++) {
-        for(unsigned int j=0; j<_infectiousMosquitoQueue[i].size(); j++) {
-            Mosquito* m = _infectiousMosquitoQueue[i][j];
-            Location* pLoc = m->getLocation();
-            if (gsl_rng_uniform(RNG)<_par->betaMP) {                      // infectious mosquito bites
-
-                // take sum of people in the location, weighting by time of day
-                double exposuretime[(int) NUM_OF_TIME_PERIODS];
-                double totalExposureTime = 0;
-                for (int t=0; t<(int) NUM_OF_TIME_PERIODS; t++) {
-                    exposuretime[t] = pLoc->getNumPerson((TimePeriod) t) * DAILY_BITING_PDF[t];
-                    totalExposureTime += exposuretime[t];
-                }
-                if ( totalExposureTime > 0 ) {
-                    double r = gsl_rng_uniform(RNG) * totalExposureTime;
-                    int timeofday;
-                    for (timeofday=0; timeofday<(int) NUM_OF_TIME_PERIODS - 1; timeofday++) {
-                        if (r<exposuretime[timeofday]) {
-                            // bite at this time of day
-                            break;
-                        }
-                        r -= exposuretime[timeofday];
-                    }
-                    int idx = floor(r*pLoc->getNumPerson((TimePeriod) timeofday)/exposuretime[timeofday]);
-                    Person* p = pLoc->getPerson(idx, (TimePeriod) timeofday);
-                    Serotype serotype = m->getSerotype();
-                    if (p->infect(m->getID(), serotype, _nDay, pLoc->getID())) {
-                        _nNumNewlyInfected[(int) serotype][_nDay]++;
-                        if (_bNoSecondaryTransmission) {
-                            p->kill();                       // kill secondary cases so they do not transmit
-                        }
-                        else {
-                            // NOTE: We are storing the location ID of infection, not person ID!!!
-                            // add to queue
-                            _exposedQueue[p->getInfectiousTime()-_nDay].push_back(p);
-                        }
-                    }
-                }
+    // who is where does not change while mosquitoes bite, so each location's exposure weights are computed at most once
+    ++_nBitingRound;
+    if (_exposureRound.size() != _location.size()) {
+        _exposure.assign(_location.size() * (NUM_OF_TIME_PERIODS + 1), 0.0);
+        _exposureRound.assign(_location.size(), 0);
+    }
+    if (_par->eMosquitoBiteModel == BINOMIAL_BITES and _biteGroupHead.size() != _location.size() * NUM_OF_SEROTYPES) {
+        _biteGroupHead.assign(_location.size() * NUM_OF_SEROTYPES, NO_BITER);
+        _biteGroupAnonymous.assign(_location.size() * NUM_OF_SEROTYPES, 0);
+    }
+
+    // tiles choose whom their mosquitoes bite in parallel, and sort the bites by the bitten person's block;
+    // blocks of people are then infected in parallel (see _applyBites()).  only the community's records of new
+    // infections are left for last, and they are made in the order the bites were chosen.
+    _forEachTile([&](SpatialTile& tile) {
+        if (_par->eMosquitoBiteModel == BINOMIAL_BITES) {
+            _binomialBites(tile);
+        } else {
+            _bernoulliBites(tile);
+        }
+        tile.bitesByBlock.resize(_biteBlockRNG.size());
+        for (unsigned int i = 0; i < tile.bites.size(); ++i) {
+            const Person* p = tile.bites[i].person;
+            if (not _isWholeHousehold(p)) {
+                cerr << "ERROR: person " << p->getID() << " shares a home at night with someone who lives elsewhere" << endl;
+                exit(-1612);
             }
+            tile.bitesByBlock[_biteBlockOf(p)].push_back(i);
+        }
+    });
+    _threadPool.run(_biteBlockRNG.size(), [&](unsigned int b) { _applyBites(b); });
+    for (SpatialTile* tile: _tiles) {
+        for (const InfectiousBite &bite: tile->bites) {
+            if (bite.infects) _recordInfectiousBite(bite);
         }
+        tile->bites.clear();
+        for (vector<unsigned int> &b: tile->bitesByBlock) b.clear();
     }
     return;
 }
 
 
-void Community::humanToMosquitoTransmission() {
-    for (Location* loc: _isHot[_nDay]) {
-        double sumviremic = 0.0;
-        double sumnonviremic = 0.0;
-        vector<double> sumserotype(NUM_OF_SEROTYPES,0.0);                                    // serotype fractions at location
-
-        // calculate fraction of people who are viremic
-        for (int timeofday=0; timeofday<(int) NUM_OF_TIME_PERIODS; timeofday++) {
-            for (int i=loc->getNumPerson((TimePeriod) timeofday)-1; i>=0; i--) {
-                Person* p = loc->getPerson(i, (TimePeriod) timeofday);
-                if (p->isViremic(_nDay)) {
-                    double vaceffect = (p->isVaccinated()?(1.0-_par->fVEI):1.0);
-                    int serotype = (int) p->getSerotype();
-                    if (vaceffect==1.0) {
-                        sumviremic += DAILY_BITING_PDF[timeofday];
-                        sumserotype[serotype] += DAILY_BITING_PDF[timeofday];
-                    } else {
-                        sumviremic += DAILY_BITING_PDF[timeofday]*vaceffect;
-                        sumserotype[serotype] += DAILY_BITING_PDF[timeofday]*vaceffect;
-                        // a vaccinated person is treated like a fraction of an infectious person and a fraction of a non-infectious person
-                        sumnonviremic += DAILY_BITING_PDF[timeofday]*(1.0-vaceffect);
-                    }
-                } else {
-                    sumnonviremic += DAILY_BITING_PDF[timeofday];
-                }
+// Does everyone at p's home at night live there?  An infant's mother is found among them (see Location::findMom()),
+// and bites are applied in parallel by household (see _biteBlockOf()), so she must be in the infant's block.
+bool Community::_isWholeHousehold(const Person* p) const {
+    Location* home = p->getLocation(HOME_NIGHT);
+    for (int i = 0; i < home->getNumPerson(HOME_NIGHT); ++i) {
+        if (home->getPerson(i, HOME_NIGHT)->getLocation(HOME_NIGHT) != home) return false;
+    }
+    return true;
+}
+
+
+// Applies today's bites on the people in one block.  A person bitten more than once tries the bites in the
+// order they were chosen (by tile, then within the tile), so the first one that can infect them does, and the
+// rest fail on their new immunity.  Each person's infection is drawn from their own stream for the day (and the
+// run, so that runs after a reset() are independent), so it depends neither on how people are split into blocks
+// nor on the threads.  Blocks are made of whole households: an infant's infection reads the immunity of a mother
+// in the same household, which may be infected the same day (first if she has the lower ID, as with a single block).
+void Community::_applyBites(unsigned int block) {
+    vector<InfectiousBite*>& bites = _biteBlockBites[block];
+    bites.clear();
+    for (SpatialTile* tile: _tiles) {
+        for (unsigned int i: tile->bitesByBlock[block]) bites.push_back(&tile->bites[i]);
+    }
+    stable_sort(bites.begin(), bites.end(), [](const InfectiousBite* a, const InfectiousBite* b) { return a->person->getID() < b->person->getID(); });
+
+    const gsl_rng* rng = _biteBlockRNG[block];
+    const unsigned long int seed = RandomStreams::runSeed(_rng.getSeed(), _nRun);
+    for (unsigned int i = 0; i < bites.size(); ++i) {
+        InfectiousBite& bite = *bites[i];
+        Person* p = bite.person;
+        if (i == 0 or bites[i-1]->person != p) {
+            // epoch 0 belongs to the community's and tiles' own streams
+            RandomStreams::set(rng, seed, HUMAN_INFECTION_RNG, p->getID(), _nDay + 1);
+        }
+        bite.infects = p->acquireInfection(bite.mosquitoID, bite.serotype, _nDay, bite.location->getID(), rng);
+        if (bite.infects and _bNoSecondaryTransmission) {
+            p->kill();                       // kill secondary cases so they do not transmit
+        }
+    }
+}
+
+
+void Community::_bernoulliBites(SpatialTile& tile) {
+    const gsl_rng* rng = tile.getRNG(BITING_RNG);
+    for(unsigned int i=0; i<tile.infectiousMosquitoQueue.size(); i++) {
+        for (unsigned int m: tile.infectiousMosquitoQueue[i]) {
+            if (gsl_rng_uniform(rng)<_par->betaMP) {                      // infectious mosquito bites
+                _chooseBitten(tile, tile.mosquitoes.getLocation(m), tile.mosquitoes.getSerotype(m), tile.mosquitoes.getID(m));
             }
         }
+        for (const MosquitoCohort &c: tile.infectiousMosquitoCohorts[i]) {
+            int numbites = gsl_ran_binomial(rng, _par->betaMP, c.count); // how many of the cohort bite
+            while (numbites-->0) _chooseBitten(tile, _location[c.locationID], c.serotype, ANONYMOUS_MOSQUITO_ID);
+        }
+    }
+}
+
 
-        if (sumviremic>0.0) {
-            for (int i=0; i<NUM_OF_SEROTYPES; i++) {
-                sumserotype[i] /= sumviremic;
+// Binomial counterpart of the per-mosquito draws in _bernoulliBites(): infectious mosquitoes are grouped by
+// location and serotype, the number that bite in each group is drawn at once, and the biters are then sampled
+// from the group without replacement (so individual mosquitoes are still credited with bites)
+void Community::_binomialBites(SpatialTile& tile) {
+    const gsl_rng* rng = tile.getRNG(BITING_RNG);
+    // collect groups in queue order, so the order of draws is well-defined
+    for(unsigned int i=0; i<tile.infectiousMosquitoQueue.size(); i++) {
+        for (unsigned int m: tile.infectiousMosquitoQueue[i]) {
+            const unsigned int g = tile.mosquitoes.getLocationID(m) * NUM_OF_SEROTYPES + tile.mosquitoes.getSerotype(m);
+            if (_biteGroupHead[g] == NO_BITER and _biteGroupAnonymous[g] == 0) tile.biteGroups.push_back(g);
+            tile.biterNext.push_back(_biteGroupHead[g]);
+            _biteGroupHead[g] = tile.biters.size();
+            tile.biters.push_back(m);
+        }
+        for (const MosquitoCohort &c: tile.infectiousMosquitoCohorts[i]) {
+            const unsigned int g = c.locationID * NUM_OF_SEROTYPES + c.serotype;
+            if (_biteGroupHead[g] == NO_BITER and _biteGroupAnonymous[g] == 0) tile.biteGroups.push_back(g);
+            _biteGroupAnonymous[g] += c.count;
+        }
+    }
+
+    vector<unsigned int>& members = tile.biteGroupMembers;
+    for (unsigned int g: tile.biteGroups) {
+        Location* pLoc = _location[g / NUM_OF_SEROTYPES];
+        const Serotype serotype = (Serotype) (g % NUM_OF_SEROTYPES);
+        members.clear();
+        for (unsigned int b = _biteGroupHead[g]; b != NO_BITER; b = tile.biterNext[b]) members.push_back(tile.biters[b]);
+        const int named = members.size();
+        const int total = named + _biteGroupAnonymous[g];
+
+        const int numbites = gsl_ran_binomial(rng, _par->betaMP, total);       // how many of the group bite
+        int chosen = 0;                                                        // named biters so far, moved to the front
+        for (int k = 0; k < numbites; ++k) {
+            const int r = (named > chosen) ? gsl_rng_uniform_int(rng, total - k) : INT_MAX;
+            if (r < named - chosen) {
+                std::swap(members[chosen], members[chosen + r]);
+                _chooseBitten(tile, pLoc, serotype, tile.mosquitoes.getID(members[chosen++]));
+            } else {
+                _chooseBitten(tile, pLoc, serotype, ANONYMOUS_MOSQUITO_ID);
             }
-            int locid = loc->getID();                   // location ID
-            int m = int(loc->getBaseMosquitoCapacity() * (1.0-loc->getCurrentVectorControlEfficacy(_nDay)) * getMosquitoMultiplier() + 0.5);  // number of mosquitoes
-            m -= loc->getCurrentInfectedMosquitoes(); // subtract off the number of already-infected mosquitos
-            if (m<0) m=0; // more infected mosquitoes than the base capacity, presumable due to immigration
-                                                                  // how many susceptible mosquitoes bite viremic hosts in this location?
-            const double prob_infecting_bite = _par->betaPM*sumviremic/(sumviremic+sumnonviremic);
-            int numbites = gsl_ran_binomial(RNG, prob_infecting_bite, m);
-            while (numbites-->0) {
-                int serotype;                                     // which serotype infects mosquito
-                if (sumserotype[0]==1.0) {
-                    serotype = 0;
-                } else {
-                    double r = gsl_rng_uniform(RNG);
-                    for (serotype=0; serotype<NUM_OF_SEROTYPES && r>sumserotype[serotype]; serotype++)
-                        r -= sumserotype[serotype];
-                }
-                attemptToAddMosquito(loc, (Serotype) serotype, locid, prob_infecting_bite);
+        }
+        _biteGroupHead[g] = NO_BITER;
+        _biteGroupAnonymous[g] = 0;
+    }
+    tile.biteGroups.clear();
+    tile.biters.clear();
+    tile.biterNext.clear();
+}
+
+
+// the number of people at pLoc at each time of day, weighted by the biting probability then, followed by the total
+const double* Community::_getExposure(Location* pLoc) {
+    double* exposuretime = &_exposure[pLoc->getID() * (NUM_OF_TIME_PERIODS + 1)];
+    if (_exposureRound[pLoc->getID()] != _nBitingRound) {
+        double totalExposureTime = 0;
+        for (int t=0; t<(int) NUM_OF_TIME_PERIODS; t++) {
+            exposuretime[t] = pLoc->getNumPerson((TimePeriod) t) * DAILY_BITING_PDF[t];
+            totalExposureTime += exposuretime[t];
+        }
+        exposuretime[NUM_OF_TIME_PERIODS] = totalExposureTime;
+        _exposureRound[pLoc->getID()] = _nBitingRound;
+    }
+    return exposuretime;
+}
+
+
+// an infectious mosquito in tile bites someone at pLoc; who is bitten is recorded in the tile's bites
+void Community::_chooseBitten(SpatialTile& tile, Location* pLoc, Serotype serotype, int mosquitoID) {
+    // take sum of people in the location, weighting by time of day
+    const double* exposuretime = _getExposure(pLoc);
+    const double totalExposureTime = exposuretime[NUM_OF_TIME_PERIODS];
+    if ( totalExposureTime > 0 ) {
+        double r = gsl_rng_uniform(tile.getRNG(BITING_RNG)) * totalExposureTime;
+        int timeofday;
+        for (timeofday=0; timeofday<(int) NUM_OF_TIME_PERIODS - 1; timeofday++) {
+            if (r<exposuretime[timeofday]) {
+                // bite at this time of day
+                break;
             }
+            r -= exposuretime[timeofday];
         }
+        int idx = floor(r*pLoc->getNumPerson((TimePeriod) timeofday)/exposuretime[timeofday]);
+        tile.bites.emplace_back(pLoc->getPerson(idx, (TimePeriod) timeofday), pLoc, serotype, mosquitoID);
     }
-    _isHot[_nDay].clear();
+}
+
+
+// the community's records of a bite that infected someone
+void Community::_recordInfectiousBite(const InfectiousBite& bite) {
+    Person* p = bite.person;
+    flagNewInfection(p);
+    _nNumNewlyInfected[(int) bite.serotype][_nDay]++;
+    if (not _bNoSecondaryTransmission) {
+        // NOTE: We are storing the location ID of infection, not person ID!!!
+        // add to queue
+        _exposedQueue[p->getInfectiousTime()-_nDay].push_back(p);
+    }
+}
+
+
+void Community::humanToMosquitoTransmission() {
+    for (Person* p: _diseaseEvents.get(_nDay)) _updateViremiaTally(p); // includes anyone infected earlier today
+    _diseaseEvents.clearDay(_nDay);
+
+    for (Location* loc: _isHot.get(_nDay)) _tileAt(loc).hot.push_back(loc);
+    _forEachTile([&](SpatialTile& tile) {
+        for (Location* loc: tile.hot) _infectMosquitoes(tile, loc);
+        tile.hot.clear();
+    });
+    _isHot.clearDay(_nDay);
     return;
 }
 
 
+// mosquitoes at loc (a hot location in tile) bite the people there, and some are infected
+void Community::_infectMosquitoes(SpatialTile& tile, Location* loc) {
+    // a vaccinated person is treated like a fraction of an infectious person and a fraction of a non-infectious person
+    const double vaceffect = 1.0 - _par->fVEI;
+    double sumviremic = 0.0;
+    double sumnonviremic = 0.0;
+    vector<double> sumserotype(NUM_OF_SEROTYPES,0.0);                                    // serotype fractions at location
+
+    // calculate fraction of people who are viremic
+    for (int timeofday=0; timeofday<(int) NUM_OF_TIME_PERIODS; timeofday++) {
+        const TimePeriod t = (TimePeriod) timeofday;
+        int numviremic = 0;
+        int numvaccinated = 0;
+        for (int s=0; s<NUM_OF_SEROTYPES; s++) {
+            const int unvac = loc->getNumViremic(t, false, (Serotype) s);
+            const int vac   = loc->getNumViremic(t, true, (Serotype) s);
+            sumserotype[s] += DAILY_BITING_PDF[timeofday]*(unvac + vac*vaceffect);
+            numviremic += unvac + vac;
+            numvaccinated += vac;
+        }
+        sumnonviremic += DAILY_BITING_PDF[timeofday]*(loc->getNumPerson(t) - numviremic + numvaccinated*(1.0-vaceffect));
+    }
+    for (int s=0; s<NUM_OF_SEROTYPES; s++) sumviremic += sumserotype[s];
+
+    if (sumviremic>0.0) {
+        for (int i=0; i<NUM_OF_SEROTYPES; i++) {
+            sumserotype[i] /= sumviremic;
+        }
+        int m = int(loc->getBaseMosquitoCapacity() * (1.0-loc->getCurrentVectorControlEfficacy(_nDay)) * getMosquitoMultiplier() + 0.5);  // number of mosquitoes
+        m -= loc->getCurrentInfectedMosquitoes(); // subtract off the number of already-infected mosquitos
+        if (m<0) m=0; // more infected mosquitoes than the base capacity, presumable due to immigration
+                                                              // how many susceptible mosquitoes bite viremic hosts in this location?
+        const double prob_infecting_bite = _par->betaPM*sumviremic/(sumviremic+sumnonviremic);
+        int numbites = gsl_ran_binomial(tile.getRNG(BITING_RNG), prob_infecting_bite, m);
+        while (numbites-->0) {
+            int serotype;                                     // which serotype infects mosquito
+            if (sumserotype[0]==1.0) {
+                serotype = 0;
+            } else {
+                double r = gsl_rng_uniform(tile.getRNG(BITING_RNG));
+                for (serotype=0; serotype<NUM_OF_SEROTYPES && r>sumserotype[serotype]; serotype++)
+                    r -= sumserotype[serotype];
+            }
+            attemptToAddMosquito(loc, (Serotype) serotype, prob_infecting_bite);
+        }
+    }
+}
+
+
 void Community::_advanceTimers() {
     // advance incubation in people
     for (unsigned int i=0; i<_exposedQueue.size()-1; i++) {
@@ -960,69 +1859,53 @@ void Community::_advanceTimers() {
     }
     _exposedQueue.back().clear();
 
+    _forEachTile([&](SpatialTile& tile) { _advanceMosquitoTimers(tile); });
+    return;
+}
+
+
+void Community::_advanceMosquitoTimers(SpatialTile& tile) {
     // delete infected mosquitoes that are dying today
-    vector<Mosquito*>::iterator itr;
-    for(itr = _infectiousMosquitoQueue.front().begin(); itr != _infectiousMosquitoQueue.front().end(); ++itr ) {
-        delete (*itr);
-    }
+    for (unsigned int m: tile.infectiousMosquitoQueue.front()) tile.mosquitoes.kill(m);
 
-    // advance age of infectious mosquitoes
-    for (unsigned int i=0; i<_infectiousMosquitoQueue.size()-1; i++) {
-        _infectiousMosquitoQueue[i] = _infectiousMosquitoQueue[i+1];
-#ifndef __INTEL_COMPILER
-        _infectiousMosquitoQueue[i].shrink_to_fit();
-#endif
-    }
+    for (const MosquitoCohort &c: tile.infectiousMosquitoCohorts.front()) _location[c.locationID]->removeInfectedMosquitoes(c.count);
 
-    _infectiousMosquitoQueue.back().clear();
-#ifndef __INTEL_COMPILER
-    _infectiousMosquitoQueue.back().shrink_to_fit();
-#endif
+    // advance age of infectious mosquitoes
+    tile.infectiousMosquitoQueue.advance();
+    tile.infectiousMosquitoCohorts.advance();
 
-    assert(_exposedMosquitoQueue.size() > 0);
     // advance incubation period of exposed mosquitoes
-    for (unsigned int mnum=0; mnum<_exposedMosquitoQueue[0].size(); mnum++) {
-        Mosquito* m = _exposedMosquitoQueue[0][mnum];
+    for (unsigned int m: tile.exposedMosquitoQueue.front()) {
         // incubation over: some mosquitoes become infectious
-        int daysinfectious = m->getAgeDeath() - m->getAgeInfectious(); // - MOSQUITO_INCUBATION;
-        assert((unsigned) daysinfectious < _infectiousMosquitoQueue.size());
-        _infectiousMosquitoQueue[daysinfectious].push_back(m);
+        int daysinfectious = tile.mosquitoes.getAgeDeath(m) - tile.mosquitoes.getAgeInfectious(m); // - MOSQUITO_INCUBATION;
+        assert((unsigned) daysinfectious < tile.infectiousMosquitoQueue.size());
+        tile.infectiousMosquitoQueue[daysinfectious].push_back(m);
     }
-
-    for (unsigned int i=0; i<_exposedMosquitoQueue.size()-1; i++) {
-        _exposedMosquitoQueue[i] = _exposedMosquitoQueue[i+1];
-#ifndef __INTEL_COMPILER
-        _exposedMosquitoQueue[i].shrink_to_fit();
-#endif
+    tile.exposedMosquitoQueue.advance();
+    for (const MosquitoCohort &c: tile.exposedMosquitoCohorts.front()) {
+        assert((unsigned) c.daysInfectious < tile.infectiousMosquitoCohorts.size());
+        tile.infectiousMosquitoCohorts[c.daysInfectious].emplace_back(c.locationID, c.serotype, 0, c.count);
     }
-    _exposedMosquitoQueue.back().clear();
-#ifndef __INTEL_COMPILER
-    _exposedMosquitoQueue.back().shrink_to_fit();
-#endif
-    return;
+    tile.exposedMosquitoCohorts.advance();
 }
 
 
 void Community::_modelMosquitoMovement() {
-    // move mosquitoes
-    for(unsigned int i=0; i<_infectiousMosquitoQueue.size(); i++) {
-        for(unsigned int j=0; j<_infectiousMosquitoQueue[i].size(); j++) {
-            Mosquito* m = _infectiousMosquitoQueue[i][j];
-            moveMosquito(m);
-        }
-    }
-    for(unsigned int i=0; i<_exposedMosquitoQueue.size(); i++) {
-        for(unsigned int j=0; j<_exposedMosquitoQueue[i].size(); j++) {
-            Mosquito* m = _exposedMosquitoQueue[i][j];
-            moveMosquito(m);
-        }
-    }
+    // move mosquitoes; those that leave their tile are delivered once all tiles have moved theirs
+    _forEachTile([&](SpatialTile& tile) {
+        for(unsigned int i=0; i<tile.infectiousMosquitoQueue.size(); i++) moveMosquitoes(tile, tile.infectiousMosquitoQueue[i], true, i);
+        for(unsigned int i=0; i<tile.exposedMosquitoQueue.size(); i++) moveMosquitoes(tile, tile.exposedMosquitoQueue[i], false, i);
+        for(unsigned int i=0; i<tile.infectiousMosquitoCohorts.size(); i++) moveMosquitoes(tile, tile.infectiousMosquitoCohorts[i], true, i);
+        for(unsigned int i=0; i<tile.exposedMosquitoCohorts.size(); i++) moveMosquitoes(tile, tile.exposedMosquitoCohorts[i], false, i);
+    });
+    _receiveMigrants();
     return;
 }
 
 
 void Community::tick(int day) {
     _nDay = day;
+    _nTalliedDays = max(_nTalliedDays, (unsigned int) _nDay + 1);
     //if ((_nDay+1)%365==0) { swapImmuneStates(1.0); }                     // randomize and advance immune states on
     _processDelayedBirthdays();
 
@@ -1048,7 +1931,7 @@ void Community::tick(int day) {
 // getNumInfected - counts number of infected residents
 int Community::getNumInfected(int day) {
     int count=0;
-    for (Person* p: _people) { if (p->isInfected(day)) count++; }
+    for (Person* p: (day >= _nActiveInfectionsDay ? _activeInfections : _people)) { if (p->isInfected(day)) count++; }
     return count;
 }
 
@@ -1056,17 +1939,17 @@ int Community::getNumInfected(int day) {
 // getNumSymptomatic - counts number of symptomatic residents
 int Community::getNumSymptomatic(int day) {
     int count=0;
-    for (Person* p: _people) { if (p->isSymptomatic(day)) count++; }
+    for (Person* p: (day >= _nActiveInfectionsDay ? _activeInfections : _people)) { if (p->isSymptomatic(day)) count++; }
     return count;
 }
 
 // getNumSusceptible - counts number of susceptible residents
-vector<int> Community::getNumSusceptible() {
-    vector<int> counts(NUM_OF_SEROTYPES, 0);
-    for (Person* p: _people) {
-        for (int s=0; s<NUM_OF_SEROTYPES; s++) {
-            if (p->isSusceptible((Serotype) s)) counts[s]++;
-        }
-    }
-    return counts;
+vector<int> Community::getNumSusceptible() const {
+    return reducePeople(vector<int>(NUM_OF_SEROTYPES, 0),
+        [](vector<int>& counts, const Person* p) {
+            for (int s=0; s<NUM_OF_SEROTYPES; s++) {
+                if (p->isSusceptible((Serotype) s)) counts[s]++;
+            }
+        },
+        [](vector<int>& counts, const vector<int>& block) { for (int s=0; s<NUM_OF_SEROTYPES; s++) counts[s] += block[s]; });
 }
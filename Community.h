@@ -10,9 +10,14 @@
 #include <numeric>
 #include <cmath>
 #include <algorithm>
+#include <functional>
+#include "DayQueue.h"
+#include "Snapshot.h"
+#include "Mosquito.h"
+#include "RandomStreams.h"
+#include "ThreadPool.h"
 
 class Person;
-class Mosquito;
 class Location;
 
 // We use this to make sure that locations are iterated through in a well-defined order (by ID), rather than by mem address
@@ -21,22 +26,174 @@ struct LocPtrComp { bool operator()(const Location* A, const Location* B) const
 // We use this to created a vector of people, sorted by decreasing age.  Used for aging/immunity swapping.
 struct PerPtrComp { bool operator()(const Person* A, const Person* B) const { return A->getAge() > B->getAge(); } };
 
+// We use this to iterate through people in a well-defined order (by ID)
+struct PerIDComp { bool operator()(const Person* A, const Person* B) const { return A->getID() < B->getID(); } };
+
+// Objects (locations or people) flagged for each of the next few days.  Only a ring of days as
+// deep as the furthest-ahead day that can be flagged is kept; each day is a dense list,
+// deduplicated with a bitmap indexed by object ID, and sorted by ID when it is read.
+// Flags for days that have already been read are ignored.
+template <typename T, typename Comp>
+class DayFlags {
+    public:
+        DayFlags(unsigned int depth) : _slot(depth) {}
+
+        void insert(T x, int day) {
+            assert(day >= 0);
+            Slot &slot = _slot[day % _slot.size()];
+            if (slot.day < day) {
+                _reset(slot, day);                                    // slot still holds a day that has passed
+            } else if (slot.day > day) {
+                return;                                               // day has passed; nothing will read it
+            }
+            const unsigned int id = x->getID();
+            if (id >= slot.flagged.size()) slot.flagged.resize(id + 1, false);
+            if (not slot.flagged[id]) {
+                slot.flagged[id] = true;
+                slot.items.push_back(x);
+            }
+        }
+
+        const std::vector<T>& get(int day) {                          // in ID order
+            Slot &slot = _slot[day % _slot.size()];
+            if (slot.day != day) return _empty;
+            std::sort(slot.items.begin(), slot.items.end(), Comp());
+            return slot.items;
+        }
+
+        void clearDay(int day) {
+            Slot &slot = _slot[day % _slot.size()];
+            if (slot.day == day) _reset(slot, day);
+        }
+
+        void clear() { for (Slot &slot: _slot) _reset(slot, -1); }
+
+        // objects are written as IDs, and read back as byID[id]
+        void write(std::ostream& os) const {
+            for (const Slot &slot: _slot) {
+                std::vector<int> ids;
+                for (T x: slot.items) ids.push_back(x->getID());
+                snapshot::write(os, slot.day);
+                snapshot::write(os, ids);
+            }
+        }
+
+        void read(std::istream& is, const std::vector<T>& byID) {
+            for (Slot &slot: _slot) {
+                int day = -1;
+                std::vector<int> ids;
+                snapshot::read(is, day);
+                snapshot::read(is, ids);
+                _reset(slot, day);
+                for (int id: ids) {
+                    if (id < 0 or (unsigned) id >= byID.size()) { is.setstate(std::ios::failbit); return; }
+                    if ((unsigned) id >= slot.flagged.size()) slot.flagged.resize(id + 1, false);
+                    slot.flagged[id] = true;
+                    slot.items.push_back(byID[id]);
+                }
+            }
+        }
+
+    private:
+        struct Slot {
+            Slot() : day(-1) {}
+            int day;                                                  // day these objects are flagged for
+            std::vector<T> items;
+            std::vector<bool> flagged;                                // indexed by object ID
+        };
+        void _reset(Slot &slot, int day) {
+            for (T x: slot.items) slot.flagged[x->getID()] = false;
+            slot.items.clear();
+            slot.day = day;
+        }
+        std::vector<Slot> _slot;
+        const std::vector<T> _empty;
+};
+
+// A person's current contribution to the viremia tallies of the locations they visit
+struct ViremiaTally {
+    ViremiaTally() : viremic(false), vaccinated(false), serotype(NULL_SEROTYPE) { for (auto &l: location) l = nullptr; }
+    bool viremic;
+    bool vaccinated;
+    Serotype serotype;
+    Location* location[NUM_OF_TIME_PERIODS];                          // where this person is counted at each time of day
+    std::vector<Location*> extraWorkDay;                              // any further WORK_DAY listings (e.g., a person who withdraws
+                                                                      // again before returning from a previous withdrawal)
+};
+
+// An infectious bite chosen while tiles are simulated in parallel; bites are applied to people afterward
+struct InfectiousBite {
+    InfectiousBite(Person* p, Location* l, Serotype s, int m) : person(p), location(l), serotype(s), mosquitoID(m), infects(false) {}
+    Person* person;
+    Location* location;
+    Serotype serotype;
+    int mosquitoID;
+    bool infects;                                                     // set once the bite is applied
+};
+
+// A mosquito (or, in the compartmental model, a cohort) moving to a location in another tile.
+// It keeps its place in the exposed or infectious queue.
+struct MosquitoMigrant {
+    MosquitoMigrant(bool i, unsigned int d, const RestoreMosquitoPars& m) : infectious(i), day(d), mosquito(m), cohort(-1, NULL_SEROTYPE, 0, 0) {}
+    MosquitoMigrant(bool i, unsigned int d, const MosquitoCohort& c) : infectious(i), day(d), cohort(c) {}
+    bool infectious;
+    unsigned int day;                                                 // index in the queue
+    RestoreMosquitoPars mosquito;                                     // individual mosquitoes; location is the destination
+    MosquitoCohort cohort;                                            // cohorts (count > 0); locationID is the destination
+};
+
+// A spatially contiguous group of locations, and the infected mosquitoes at them.  Tiles are simulated in
+// parallel, and each tile's mosquitoes draw only from the tile's own random number streams, so results
+// depend on the number of tiles but not on the number of threads.  A mosquito that moves to another tile
+// waits in the outbox until every tile has finished moving its mosquitoes.
+struct SpatialTile {
+    SpatialTile(unsigned int n, unsigned int ntiles, const std::vector<Location*>& alllocations, const RandomStreams* communityStreams);
+    const gsl_rng* getRNG(RandomPurpose purpose) const { return _streams.get(purpose); }
+    void reseed(unsigned long int seed);
+
+    const unsigned int id;
+    std::vector<Location*> locations;                                 // in ID order
+    MosquitoPool mosquitoes;                                          // storage for the tile's infected mosquitoes
+    DayQueue<unsigned int> infectiousMosquitoQueue;                   // handles of infectious mosquitoes with n days
+                                                                      // left to live
+    DayQueue<unsigned int> exposedMosquitoQueue;                      // handles of exposed mosquitoes with n days of latency left
+    DayQueue<MosquitoCohort> infectiousMosquitoCohorts;               // compartmental model: as above, but counts of mosquitoes
+    DayQueue<MosquitoCohort> exposedMosquitoCohorts;                  // by location, serotype (and days infectious, if exposed)
+    std::vector<Location*> hot;                                       // the tile's hot locations today, in ID order
+    std::vector<InfectiousBite> bites;                                // bites by the tile's mosquitoes today
+    std::vector< std::vector<unsigned int> > bitesByBlock;            // indices into bites, by the bitten person's bite block
+    std::vector<MosquitoMigrant> outbox;                              // mosquitoes leaving the tile today
+    std::vector<unsigned int> biteGroups;                             // binomial bites: nonempty groups, in the order first seen
+    std::vector<unsigned int> biters;                                 // handles of infectious mosquitoes, as linked lists by group
+    std::vector<unsigned int> biterNext;                              // previous biter in the same group, or NO_BITER
+    std::vector<unsigned int> biteGroupMembers;                       // scratch space for sampling biters from one group
+
+    private:
+        friend class Community;                                       // snapshots include the tile's own streams
+        SpatialTile(const SpatialTile&) = delete;
+        SpatialTile& operator=(const SpatialTile&) = delete;
+        RandomStreams _streams;                                       // substream id+1, since the community's own streams
+                                                                      // (e.g., for vector control) are substream 0
+};
+
 class Community {
     public:
         Community(const Parameters* parameters);
+        Community(const Community* structure, const Parameters* parameters);  // a replicate; see Community.cpp
         virtual ~Community();
         bool loadPopulation(std::string szPop,std::string szImm, std::string szSwap);
         bool loadLocations(std::string szLocs,std::string szNet);
         bool loadMosquitoes(std::string moslocFilename, std::string mosFilename);
         int getNumPeople() const { return _people.size(); }
-        std::vector<Person*> getPeople() const { return _people; }
+        const std::vector<Person*>& getPeople() const { return _people; }
+        const std::vector<Person*>& getActiveInfections();           // people who may be infected today or later, in ID order
         int getNumInfected(int day);
         int getNumSymptomatic(int day);
-        std::vector<int> getNumSusceptible();
+        std::vector<int> getNumSusceptible() const;
         void populate(Person **parray, int targetpop);
         Person* getPersonByID(int id);
         bool infect(int id, Serotype serotype, int day);
-        void attemptToAddMosquito(Location *p, Serotype serotype, int nInfectedByID, double prob_infecting_bite);
+        void attemptToAddMosquito(Location *p, Serotype serotype, double prob_infecting_bite);
         int getDay() { return _nDay; }                                // what day is it?
         void swapImmuneStates();
         void updateDiseaseStatus();
@@ -51,7 +208,7 @@ class Community {
 
         void setExpectedExtrinsicIncubation(double n) { _expectedEIP = n; _EIP_emu = exp(log(_expectedEIP) - (_EIP_sigma*_EIP_sigma)/2.0); }
         double getExpectedExtrinsicIncubation() const { return _expectedEIP; }
-        double getEIP() const { return (_par->simpleEIP ? _expectedEIP : _EIP_emu * exp(gsl_ran_gaussian(RNG, _EIP_sigma))); }
+        double getEIP(const gsl_rng* rng) const { return (_par->simpleEIP ? _expectedEIP : _EIP_emu * exp(gsl_ran_gaussian(rng, _EIP_sigma))); }
 
         int getNumInfectiousMosquitoes();
         int getNumExposedMosquitoes();
@@ -60,34 +217,59 @@ class Community {
         void updateVaccination();          // for boosting and multi-does vaccines
         void setVES(double f);
         void setVESs(std::vector<double> f);
-        Mosquito *getInfectiousMosquito(int n);
-        Mosquito *getExposedMosquito(int n);
         std::vector< std::vector<int> > getNumNewlyInfected() { return _nNumNewlyInfected; }
         std::vector< std::vector<int> > getNumNewlySymptomatic() { return _nNumNewlySymptomatic; }
         std::vector< std::vector<int> > getNumVaccinatedCases() { return _nNumVaccinatedCases; }
         std::vector< std::vector<int> > getNumSevereCases() { return _nNumSevereCases; }
-        static void flagInfectedLocation(Location* _pLoc, int day);
+        void flagInfectedLocation(Location* _pLoc, int day);
+        void flagInfectedPerson(Person* p);                           // p has a new (or newly copied) infection
+        void flagNewInfection(Person* p);                             // flags p's infectious days, then flagInfectedPerson(p)
+        const Parameters* getPar() const { return _par; }
+        const gsl_rng* getRNG(RandomPurpose purpose) const { return _rng.get(purpose); } // this community's stream for purpose
+        unsigned long int getSeed() const { return _rng.getSeed(); }  // of this community's streams (see reseed())
 
         int ageIntervalSize(int ageMin, int ageMax) { return std::accumulate(_nPersonAgeCohortSizes+ageMin, _nPersonAgeCohortSizes+ageMax,0); }
 
         void reset();                                                 // reset the state of the community
+        bool canRestart(const Parameters* par) const;                 // built from the same files as par asks for?
+        bool restart(const Parameters* par);                          // as if newly built with par; see canRestart()
+        void reseed(unsigned long int seed);                          // moves every random stream to the start of seed's
+        bool writeSnapshot(std::ostream& os) const;                   // the state of the simulation; see Snapshot.h
+        bool readSnapshot(std::istream& is);                          // into a community built from the same files
+        bool adoptParameters(const Parameters* snapshotPar);          // after readSnapshot() of one taken with snapshotPar
         const std::vector<Location*> getLocations() const { return _location; }
-        const std::vector< std::vector<Mosquito*> > getInfectiousMosquitoes() const { return _infectiousMosquitoQueue; }
-        const std::vector< std::vector<Mosquito*> > getExposedMosquitoes() const { return _exposedMosquitoQueue; }
+        const std::vector<SpatialTile*>& getTiles() const { return _tiles; }    // infected mosquitoes are stored by tile
         const std::vector<Person*> getAgeCohort(unsigned int age) const { assert(age<_personAgeCohort.size()); return _personAgeCohort[age]; }
 
+        // Parallel reduction over [0, n): the range is split into at most REDUCTION_BLOCKS blocks, each with its
+        // own copy of empty (which must be an identity for merge); add(acc, i) is called for each i in its
+        // block, and the blocks' accumulators are merged, in order, with merge(result, acc).  The blocks do not
+        // depend on the number of threads, so neither does the result, even for floating-point sums.
+        template<typename T, typename Add, typename Merge>
+        T reduce(unsigned int n, const T& empty, Add add, Merge merge) const;
+        template<typename T, typename Add, typename Merge>       // as above, with add(acc, person) for everyone
+        T reducePeople(const T& empty, Add add, Merge merge) const {
+            return reduce(_people.size(), empty, [&](T& acc, unsigned int i) { add(acc, (const Person*) _people[i]); }, merge);
+        }
+
     protected:
-        static const Parameters* _par;
+        const Parameters* _par;
+        RandomStreams _rng;                                           // all of this community's random draws, one stream per
+                                                                      // purpose; keyed by _par->randomseed
         std::vector<Person*> _people;                                 // the array index is equal to the ID
         std::vector< std::vector<Person*> > _personAgeCohort;         // array of pointers to people of the same age
         int _nPersonAgeCohortSizes[NUM_AGE_CLASSES];                  // size of each age cohort
         double *_fMortality;                                          // mortality by year, starting from 0
         std::vector<Location*> _location;                             // the array index is equal to the ID
+        Occupancy _occupancy;                                         // who is at each location at each time of day
         std::vector< std::vector<Person*> > _exposedQueue;            // queue of people with n days of latency left
-        std::vector< std::vector<Mosquito*> > _infectiousMosquitoQueue;  // queue of infectious mosquitoes with n days
-                                                                         // left to live
-        std::vector< std::vector<Mosquito*> > _exposedMosquitoQueue;  // queue of exposed mosquitoes with n days of latency left
+        std::vector<SpatialTile*> _tiles;                             // the locations, partitioned by _buildTiles()
+        std::vector<unsigned int> _tileOf;                            // each location's tile, by location ID
+        mutable ThreadPool _threadPool;                               // simulates tiles in parallel; also used by reduce()
+        static const unsigned int REDUCTION_BLOCKS = 64;
         int _nDay;                                                    // current day
+        unsigned int _nRun;                                           // runs since the community was built or restarted, i.e.
+                                                                      // reset()s; keys the streams of people's infections
         int _nMaxInfectionParity;                                     // maximum number of infections (serotypes) per person
         bool _bNoSecondaryTransmission;
         double _fMosquitoCapacityMultiplier;                          // seasonality multiplier for mosquito capacity
@@ -99,23 +281,101 @@ class Community {
         std::vector< std::vector<int> > _nNumNewlySymptomatic;
         std::vector< std::vector<int> > _nNumVaccinatedCases;
         std::vector< std::vector<int> > _nNumSevereCases;
-        static std::vector<std::set<Location*, LocPtrComp> > _isHot;
-        static std::vector<Person*> _peopleByAge;
-        static std::map<int, std::set<std::pair<Person*, Person*> > > _delayedBirthdays;
-        static std::set<Person*> _revaccinate_set;          // not automatically re-vaccinated, just checked for boosting, multiple doses
+        unsigned int _nTalliedDays;                                   // tallies may be nonzero before this day
+        DayFlags<Location*, LocPtrComp> _isHot;
+        DayFlags<Person*, PerIDComp> _diseaseEvents;                  // people with a disease-status change scheduled, by day
+        std::vector<ViremiaTally> _viremiaTally;                      // indexed by person ID
+        std::vector<Person*> _activeInfections;                       // people whose latest infection had not resolved as of
+        int _nActiveInfectionsDay;                                    // this day, i.e. everyone infected on or after it
+        std::vector<bool> _isActiveInfection;                         // indexed by person ID
+        bool _bActiveInfectionsSorted;
+        std::vector<Person*> _changedPeople;                          // people whose state may differ from a newborn's,
+        std::vector<bool> _isChangedPerson;                           // and which they are (by ID); see reset()
+        std::vector<Person*> _peopleByAge;
+        std::map<int, std::set<std::pair<Person*, Person*> > > _delayedBirthdays;
+        std::set<Person*> _revaccinate_set;                 // not automatically re-vaccinated, just checked for boosting, multiple doses
+        // tables that do not change during a run (these and the movement tables), which replicates share with the
+        // community they were copied from
+        const Community* _structure;                                  // owner of the tables: this community, or that one
+        std::vector<PersonAttributes> _personAttributes;              // by person ID
+        std::vector<LocationAttributes> _locationAttributes;          // by location ID
+        std::vector< std::pair<int, std::vector< std::pair<int, Serotype> > > > _initialImmunity;  // from the immunity file:
+                                                                      // (day, serotype) infections of each person, by ID
+        std::vector< std::vector< std::pair<int, double> > > _swapProbabilities;  // by person ID: the nearest people one
+                                                                      // year younger, with distances (if there is a swap file)
 
-        static std::vector<std::set<Location*, LocPtrComp> > _vectorControlStartDates;
-        static std::set<Location*, LocPtrComp> _vectorControlLocations; // Locations that currently have vector control measures in place
         bool _uniformSwap;                                            // use original swapping (==true); or parse swap file (==false)
+        bool _bWeightedMosquitoMove;                                  // mosquitoes prefer nearby neighbors (mosquitoMoveModel == "weighted")
+        std::vector<unsigned int> _neighborCDFStart;                  // each location's entries in _neighborCDF, by location ID
+        std::vector<double> _neighborCDF;                             // cumulative probability of moving to each neighbor
+        std::vector<double> _exposure;                                // biting weight of each location's occupants by time of
+                                                                      // day, then their sum (NUM_OF_TIME_PERIODS+1 per location)
+        std::vector<unsigned int> _exposureRound;                     // biting round in which each location's weights were computed
+        unsigned int _nBitingRound;                                   // incremented on each call to mosquitoToHumanTransmission()
+        std::vector<unsigned int> _biteGroupHead;                     // binomial bites: last biter in each (location, serotype)
+                                                                      // group, indexed by location ID * NUM_OF_SEROTYPES + serotype
+        std::vector<int> _biteGroupAnonymous;                         // number of cohort (compartmental model) mosquitoes per group
+        std::vector<gsl_rng*> _biteBlockRNG;                          // people are split into blocks (by household) whose bites
+        std::vector< std::vector<InfectiousBite*> > _biteBlockBites;  // are applied in parallel; each block's generator is moved
+                                                                      // to the stream of each person bitten
 
-        void expandExposedQueues();
-        void expandMosquitoQueues();
-        void moveMosquito(Mosquito *m);
-        void mosquitoFilter(std::vector<Mosquito*>& mosquitoes, const double survival_prob);
+        void _buildTiles();
+        void _forEachTile(const std::function<void(SpatialTile&)>& f) { _threadPool.run(_tiles.size(), [&](unsigned int t) { f(*_tiles[t]); }); }
+        SpatialTile& _tileAt(const Location* pLoc) { return *_tiles[_tileOf[pLoc->getID()]]; }
+        Location* moveMosquito(SpatialTile& tile, unsigned int m);
+        bool _sampleMosquitoCapacity(Location* loc);
+        bool _addLocations();                                         // of _structure's attributes, to this community
+        void _addPeople();
+        void _buildMovementTables();
+        void _applyInitialImmunity();
+        void _markChanged(Person* p);
+        void _indexPeople();
+        void moveMosquitoes(SpatialTile& tile, std::vector<unsigned int>& mosquitoes, bool infectious, unsigned int day);
+        void moveMosquitoes(SpatialTile& tile, std::vector<MosquitoCohort>& cohorts, bool infectious, unsigned int day);
+        void _receiveMigrants();
+        void mosquitoFilter(SpatialTile& tile, std::vector<unsigned int>& mosquitoes, const double survival_prob);
+        void mosquitoFilter(SpatialTile& tile, std::vector<MosquitoCohort>& cohorts, const double survival_prob);
+        void _vectorControlFilter(SpatialTile& tile, std::vector<unsigned int>& mosquitoes);
+        void _vectorControlFilter(SpatialTile& tile, std::vector<MosquitoCohort>& cohorts);
+        bool _cohortSurvival(const gsl_rng* rng, MosquitoCohort &c, const double survival_prob);
+        void _mergeMosquitoCohorts(std::vector<MosquitoCohort>& cohorts);
+        void _chooseBitten(SpatialTile& tile, Location* pLoc, Serotype serotype, int mosquitoID);
+        // Blocks are made of whole households (HOME_NIGHT locations).  Blocks are applied on different threads, so
+        // this relies on Person::acquireInfection() reading no one's state but the bitten person's and that of
+        // others in the same household (an infant's mother; checked by _isWholeHousehold() for everyone bitten)
+        unsigned int _biteBlockOf(const Person* p) const {
+            return p->getLocation(HOME_NIGHT)->getID() % _biteBlockRNG.size();
+        }
+        bool _isWholeHousehold(const Person* p) const;
+        void _applyBites(unsigned int block);
+        void _recordInfectiousBite(const InfectiousBite& bite);
+        const double* _getExposure(Location* pLoc);
+        void _bernoulliBites(SpatialTile& tile);
+        void _binomialBites(SpatialTile& tile);
+        void _infectMosquitoes(SpatialTile& tile, Location* loc);
         void _advanceTimers();
+        void _advanceMosquitoTimers(SpatialTile& tile);
         void _modelMosquitoMovement();
         void _processBirthday(Person* p);
         void _processDelayedBirthdays();
         void _swapIfNeitherInfected(Person* p, Person* donor);
+        void _updateViremiaTally(Person* p);
+        void _addViremiaTally(Person* p, Location* loc);
+        void _removeViremiaTally(Person* p, Location* loc);
+        void _compactActiveInfections();
 };
+
+
+template<typename T, typename Add, typename Merge>
+T Community::reduce(unsigned int n, const T& empty, Add add, Merge merge) const {
+    const unsigned int nblocks = std::max(1u, std::min(n, REDUCTION_BLOCKS));
+    std::vector<T> partial(nblocks, empty);
+    _threadPool.run(nblocks, [&](unsigned int b) {
+        const unsigned int last = (unsigned long int) n * (b+1) / nblocks;
+        for (unsigned int i = (unsigned long int) n * b / nblocks; i < last; ++i) add(partial[b], i);
+    });
+    T result(empty);
+    for (const T& acc: partial) merge(result, acc);
+    return result;
+}
 #endif
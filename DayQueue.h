@@ -0,0 +1,53 @@
+// DayQueue.h
+// A fixed-length queue of buckets indexed by days from today.
+// Advancing a day moves the head index rather than shifting buckets, so bucket
+// storage is reused and nothing is reallocated or copied.
+#ifndef __DAYQUEUE_H
+#define __DAYQUEUE_H
+#include <vector>
+#include <assert.h>
+#include "Snapshot.h"
+
+template <typename T>
+class DayQueue {
+    public:
+        DayQueue(unsigned int n) : _bucket(n), _head(0) { assert(n > 0); }
+
+        unsigned int size() const { return _bucket.size(); }
+        std::vector<T>& operator[](unsigned int i)             { assert(i < size()); return _bucket[(_head + i) % size()]; }
+        const std::vector<T>& operator[](unsigned int i) const { assert(i < size()); return _bucket[(_head + i) % size()]; }
+        std::vector<T>& front() { return (*this)[0]; }
+        std::vector<T>& back()  { return (*this)[size() - 1]; }
+
+        // empties today's bucket, which then becomes the last (furthest-future) bucket
+        void advance() {
+            _bucket[_head].clear();
+            _head = (_head + 1) % size();
+        }
+
+        void clear() {
+            for (auto &b: _bucket) b.clear();
+            _head = 0;
+        }
+
+        unsigned int count() const {
+            unsigned int n = 0;
+            for (const auto &b: _bucket) n += b.size();
+            return n;
+        }
+
+        // buckets in day order, so the queue is read back with today's bucket first
+        void write(std::ostream& os) const {
+            for (unsigned int i = 0; i < size(); i++) snapshot::write(os, (*this)[i]);
+        }
+
+        void read(std::istream& is) {
+            _head = 0;
+            for (auto &b: _bucket) snapshot::read(is, b);
+        }
+
+    private:
+        std::vector< std::vector<T> > _bucket;
+        unsigned int _head;                                           // index of the bucket for today
+};
+#endif
@@ -10,50 +10,82 @@
 #include "Person.h"
 #include "Location.h"
 #include "Parameters.h"
+#include "Snapshot.h"
 
 using namespace dengue::standard;
 
-int Location::_nNextSerial = 0;
 //int Location::_nDefaultMosquitoCapacity;
 
-Location::Location()
-    : _person((int) NUM_OF_TIME_PERIODS, vector<Person*>(0) ) {
-    _serial = _nNextSerial++;
-    _ID = 0;
+Location::Location(int serial, const LocationAttributes* attributes, const vector<Location*>* locations) {
+    _serial = serial;
+    _ID = attributes->ID;
+    _attributes = attributes;
+    _locations = locations;
+    _occupancy = nullptr;
     _nBaseMosquitoCapacity = 0;
     _currentInfectedMosquitoes = 0;
-    _coord = make_pair(0.0, 0.0);
-    _type = NUM_OF_LOCATION_TYPES; // compileable, but not sensible value, because it must be set elsewhere
+    clearViremic();
 }
 
 
-Location::~Location() {
-    _person.clear();
-    _neighbors.clear();
+Location::~Location() {}
+
+
+void Location::clearViremic() {
+    for (int t=0; t<(int) NUM_OF_TIME_PERIODS; t++) {
+        for (int v=0; v<2; v++) {
+            for (int s=0; s<NUM_OF_SEROTYPES; s++) _nViremic[t][v][s] = 0;
+        }
+    }
+}
+
+
+// the priority queue's heap, as it is, so that events that start on the same day are in the same order when read
+namespace {
+    typedef std::priority_queue<InsecticideTreatmentEvent> EventQueue;
+    struct EventHeap : EventQueue {
+        static EventQueue::container_type& of(EventQueue& q) { return q.*(&EventHeap::c); }
+        static const EventQueue::container_type& of(const EventQueue& q) { return q.*(&EventHeap::c); }
+    };
+}
+
+
+void Location::write(std::ostream& os) const {
+    snapshot::write(os, _nBaseMosquitoCapacity);
+    snapshot::write(os, _currentInfectedMosquitoes);
+    snapshot::write(os, _nViremic);
+    snapshot::write(os, EventHeap::of(ITQ));
+}
+
+
+void Location::read(std::istream& is) {
+    snapshot::read(is, _nBaseMosquitoCapacity);
+    snapshot::read(is, _currentInfectedMosquitoes);
+    snapshot::read(is, _nViremic);
+    snapshot::read(is, EventHeap::of(ITQ));
 }
 
 
 void Location::addPerson(Person* p, int t) {
-    assert((unsigned) t < _person.size());
-    _person[t].push_back(p);
+    assert((unsigned) t < NUM_OF_TIME_PERIODS);
+    _occupancy->add(_ID, p->getID(), t);
 }
 
 
 bool Location::removePerson(Person* p, int t) {
-    //assert((unsigned) t < _person.size());
-    for (unsigned int i=0; i<_person[t].size(); i++) {
-        if (_person[t][i] == p) {
-            _person[t][i] = _person[t].back();
-            _person[t].pop_back();
-            return true;
-        }
-    }
-    return false;
+    return _occupancy->remove(_ID, p->getID(), t);
+}
+
+
+vector<Person*> Location::getResidents() {
+    vector<Person*> residents(getNumPerson(HOME_NIGHT));
+    for (unsigned int i=0; i<residents.size(); i++) residents[i] = getPerson(i, HOME_NIGHT);
+    return residents;
 }
 
 
 // Calling scope must verify that returned person is not nullptr
-Person* Location::findMom() {
+Person* Location::findMom(const gsl_rng* rng) {
     vector<Person*> residents = getResidents();
     vector<Person*> potential_moms;
     int minage = 15;
@@ -62,16 +94,16 @@ Person* Location::findMom() {
         if (p->getSex() == FEMALE and p->getAge() >= minage and p->getAge() <= maxage) potential_moms.push_back(p);
     }
     if (potential_moms.size() == 0) return nullptr;
-    int r = gsl_rng_uniform_int(RNG, potential_moms.size());
+    int r = gsl_rng_uniform_int(rng, potential_moms.size());
     Person* mom = potential_moms[r];
     return mom;
 }
 
 
-// addNeighbor - adds location p to the location's neighbor list.
+// addNeighbor - adds location id to the location's neighbor list.
 // Note that this relationship is one-way.
-void Location::addNeighbor(Location* p) {
-    for (unsigned int i=0; i<_neighbors.size(); i++)
-        if (_neighbors[i]==p) return;                                                   // already a neighbor
-    _neighbors.push_back(p);
+void LocationAttributes::addNeighbor(int id) {
+    for (unsigned int i=0; i<neighbors.size(); i++)
+        if (neighbors[i]==id) return;                                                   // already a neighbor
+    neighbors.push_back(id);
 }
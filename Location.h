@@ -5,6 +5,8 @@
 #define __LOCATION_H
 
 #include <queue>
+#include <iostream>
+#include "Occupancy.h"
 
 class Person;
 
@@ -22,25 +24,37 @@ inline bool operator<(const InsecticideTreatmentEvent& lhs, const InsecticideTre
 }
 
 
+// What the location and network files say about a location, which never changes during a run.
+// Replicates of a community share one copy of these (see Community.h).
+struct LocationAttributes {
+    LocationAttributes() : ID(0), type(NUM_OF_LOCATION_TYPES), trialArm(0), surveilled(false), coord(0.0, 0.0) {}
+    void addNeighbor(int id);                                         // one-way; ignores a location already listed
+    int ID;                                                           // original identifier in location file
+    LocationType type;                                                // NUM_OF_LOCATION_TYPES until it is read
+    int trialArm;
+    bool surveilled;
+    std::pair<double, double> coord;                                  // (x,y) coordinates for location
+    std::vector<int> neighbors;                                       // location IDs
+};
+
+
 class Location {
     public:
-        Location();
+                                                                      // locations resolves the neighbor IDs in attributes
+        Location(int serial, const LocationAttributes* attributes, const std::vector<Location*>* locations);
         virtual ~Location();
-        void setID(int id) { _ID = id; }
         int getID() const { return _ID; }
         int getSerial() const { return _serial; }
-        void setType(LocationType t) { _type = t; }
-        LocationType getType() const { return _type; }
-        void setTrialArm(int trial_arm) { _trial_arm = trial_arm; }
-        int getTrialArm() const { return _trial_arm; }
-        void setSurveilled(bool surveilled) { _surveilled = surveilled; }
-        bool isSurveilled() const { return _surveilled; }
+        LocationType getType() const { return _attributes->type; }
+        int getTrialArm() const { return _attributes->trialArm; }
+        bool isSurveilled() const { return _attributes->surveilled; }
 
+        void setOccupancy(Occupancy* o) { _occupancy = o; }          // where this location's occupants are stored
         void addPerson(Person *p, int t);
         bool removePerson(Person *p, int t);
-        int getNumPerson(TimePeriod timeofday) const { return _person[(int) timeofday].size(); }
-        std::vector<Person*> getResidents() { return _person[HOME_NIGHT]; }
-        Person* findMom();                                            // Try to find a resident female of reproductive age
+        int getNumPerson(TimePeriod timeofday) const { return _occupancy->size(_ID, (int) timeofday); }
+        std::vector<Person*> getResidents();
+        Person* findMom(const gsl_rng* rng);                          // Try to find a resident female of reproductive age
         void setBaseMosquitoCapacity(int capacity) { _nBaseMosquitoCapacity = capacity; }
                                                                                       // not really killing of I and S mosquitoes in the same way . . .
         int getBaseMosquitoCapacity() const { return _nBaseMosquitoCapacity; }
@@ -52,6 +66,7 @@ class Location {
         void updateVectorControlQueue(int now) {
             while (vectorControlScheduled() and (now >= ITQ.top().end_day)) ITQ.pop(); }
         inline bool vectorControlScheduled() const { return (not ITQ.empty()); }
+        void clearVectorControl() { while (vectorControlScheduled()) ITQ.pop(); }
         // vectorControlActive() assumes updateVectorControlQueue() has been called recently enough that the top element is not out-of-date
         bool vectorControlActive(int now) const {
             assert(ITQ.empty() or now < ITQ.top().end_day);
@@ -64,31 +79,31 @@ class Location {
         void removeInfectedMosquito() { _currentInfectedMosquitoes--; }
         void removeInfectedMosquitoes(int n) { _currentInfectedMosquitoes -= n; }
         void clearInfectedMosquitoes() { _currentInfectedMosquitoes = 0; }
-        void addNeighbor(Location *p);
-        int getNumNeighbors() const { return _neighbors.size(); }
-        Location *getNeighbor(int n) { return _neighbors[n]; }
-        inline Person* getPerson(int idx, TimePeriod timeofday) { return _person[(int) timeofday][idx]; }
-        void setCoordinates(std::pair<double, double> c) { _coord = c; }
-        std::pair<double, double> getCoordinates() { return _coord; }
-        void setX(double x) { _coord.first = x; }
-        void setY(double y) { _coord.second = y; }
-        double getX() const { return _coord.first; }
-        double getY() const { return _coord.second; }
+        // tallies of viremic people here, by time of day, vaccination status and serotype; maintained by Community
+        void addViremicPerson(TimePeriod t, bool vaccinated, Serotype s) { _nViremic[(int) t][vaccinated][(int) s]++; }
+        void removeViremicPerson(TimePeriod t, bool vaccinated, Serotype s) { _nViremic[(int) t][vaccinated][(int) s]--; assert(_nViremic[(int) t][vaccinated][(int) s] >= 0); }
+        int getNumViremic(TimePeriod t, bool vaccinated, Serotype s) const { return _nViremic[(int) t][vaccinated][(int) s]; }
+        void clearViremic();
+        void write(std::ostream& os) const;                           // mosquitoes, viremic people and vector control,
+        void read(std::istream& is);                                  // for a snapshot
+        int getNumNeighbors() const { return _attributes->neighbors.size(); }
+        Location *getNeighbor(int n) { return (*_locations)[_attributes->neighbors[n]]; }
+        inline Person* getPerson(int idx, TimePeriod timeofday) { return _occupancy->getPerson(_ID, (int) timeofday, idx); }
+        std::pair<double, double> getCoordinates() { return _attributes->coord; }
+        double getX() const { return _attributes->coord.first; }
+        double getY() const { return _attributes->coord.second; }
 
         bool operator == ( const Location* other ) const { return ( ( _ID == other->_ID ) && ( _serial == other->_serial ) ); }
 
     protected:
         int _ID;                                                      // original identifier in location file
-        int _serial;                                                  // unique identifier assigned on construction
-        LocationType _type;
-        int _trial_arm;
-        bool _surveilled;
-        std::vector< std::vector<Person*> > _person;                  // pointers to person who come to this location
+        int _serial;                                                  // identifier assigned on construction, unique within a community
+        const LocationAttributes* _attributes;                        // owned by the community that read the locations
+        const std::vector<Location*>* _locations;                     // the locations of this location's community
+        Occupancy* _occupancy;                                        // people who come to this location (owned by Community)
         int _nBaseMosquitoCapacity;                                   // "baseline" carrying capacity for mosquitoes
         int _currentInfectedMosquitoes;
-        std::vector<Location*> _neighbors;
-        static int _nNextSerial;                                      // unique ID to assign to the next Location allocated
-        std::pair<double, double> _coord;                             // (x,y) coordinates for location
+        int _nViremic[NUM_OF_TIME_PERIODS][2][NUM_OF_SEROTYPES];     // viremic people by time of day, vaccinated?, serotype
 
         std::priority_queue<InsecticideTreatmentEvent> ITQ;           // insecticide treatment event priority queue
 };
@@ -10,51 +10,116 @@
 #include <gsl/gsl_randist.h>
 #include "Mosquito.h"
 #include "Parameters.h"
+#include "Snapshot.h"
 
 using namespace dengue::standard;
 
-int Mosquito::_nNextID = 0;
-
-Mosquito::Mosquito() {
-    _nID = _nNextID++;
-    _bDead = false;
-    _nAgeInfected = -1;
-    _nAgeInfectious = -1;
-    _eSerotype = NULL_SEROTYPE;
-    _nInfectedAtID = -1;
-    _pLocation = _pOriginLocation = NULL;
+MosquitoPool::MosquitoPool(const vector<Location*>& locations, int firstID, int idStride) : _locations(locations) {
+    _nNextID = firstID;
+    _nIDStride = idStride;
 }
 
 
+unsigned int MosquitoPool::_allocate() {
+    unsigned int m;
+    if (_freeList.size() > 0) {
+        m = _freeList.back();
+        _freeList.pop_back();
+    } else {
+        m = _id.size();
+        _id.push_back(0);
+        _locationID.push_back(0);
+        _serotype.push_back(NULL_SEROTYPE);
+        _ageInfected.push_back(0);
+        _ageInfectious.push_back(0);
+        _ageDeath.push_back(0);
+    }
+    return m;
+}
+
 
-Mosquito::Mosquito(Location* p, Serotype serotype, int nInfectedAtID, int nExternalIncubationPeriod, double prob_infecting_bite) {
-    _nID = _nNextID++;
-    _bDead = false;
-    _eSerotype = serotype;
-    _nInfectedAtID = nInfectedAtID;
+void MosquitoPool::sampleAges(const gsl_rng* rng, double prob_infecting_bite, int &ageInfected, int &ageDeath) {
     // extract precalculated age CDF given the specified prob_infecting_bite
-    vector<double> age_cdf = MOSQUITO_FIRST_BITE_AGE_CDF_MESH[(int) (prob_infecting_bite * (MOSQUITO_FIRST_BITE_AGE_CDF_MESH.size()-1))]; //MOSQUITO_AGE_CDF;
-    _nAgeInfected = Parameters::sampler(age_cdf, gsl_rng_uniform(RNG));
-    _nAgeInfectious = _nAgeInfected + nExternalIncubationPeriod;
-    _nAgeDeath = _nAgeInfected; // can't be younger than this
-    double r = 1.0-(gsl_rng_uniform(RNG)*(1.0-MOSQUITO_DEATHAGE_CDF[_nAgeInfected]));
-    _nAgeDeath = Parameters::sampler(MOSQUITO_DEATHAGE_CDF, r, _nAgeDeath);
-    //cerr << _nAgeInfected << " " << _nAgeDeath << endl;
-    _pLocation = _pOriginLocation = p;
-    _pLocation->addInfectedMosquito();
+    const vector<double>& age_cdf = MOSQUITO_FIRST_BITE_AGE_CDF_MESH[(int) (prob_infecting_bite * (MOSQUITO_FIRST_BITE_AGE_CDF_MESH.size()-1))]; //MOSQUITO_AGE_CDF;
+    ageInfected = Parameters::sampler(age_cdf, gsl_rng_uniform(rng));
+    // can't be younger than age infected
+    double r = 1.0-(gsl_rng_uniform(rng)*(1.0-MOSQUITO_DEATHAGE_CDF[ageInfected]));
+    ageDeath = Parameters::sampler(MOSQUITO_DEATHAGE_CDF, r, ageInfected);
+}
+
+
+unsigned int MosquitoPool::create(const gsl_rng* rng, Location* p, Serotype serotype, int nExternalIncubationPeriod, double prob_infecting_bite) {
+    const unsigned int m = _allocate();
+    _id[m] = _newID();
+    _serotype[m] = serotype;
+    int ageInfected, ageDeath;
+    sampleAges(rng, prob_infecting_bite, ageInfected, ageDeath);
+    _ageInfected[m] = ageInfected;
+    _ageInfectious[m] = ageInfected + nExternalIncubationPeriod;
+    _ageDeath[m] = ageDeath;
+    _locationID[m] = p->getID();
+    p->addInfectedMosquito();
+    return m;
+}
+
+
+unsigned int MosquitoPool::restore(const RestoreMosquitoPars* rp) {
+    const unsigned int m = _allocate();
+    _id[m] = (rp->id >= 0) ? rp->id : _newID();                       // a known ID, e.g. of a mosquito from another pool
+    _serotype[m] = rp->serotype;
+    _ageInfected[m] = rp->age_infected;
+    _ageInfectious[m] = rp->age_infectious;
+    _ageDeath[m] = rp->age_dead;
+    _locationID[m] = rp->location->getID();
+    rp->location->addInfectedMosquito();
+    return m;
+}
+
+
+void MosquitoPool::kill(unsigned int m) {
+    assert(m < _id.size());
+    getLocation(m)->removeInfectedMosquito();
+    _freeList.push_back(m);
+}
+
+
+void MosquitoPool::updateLocation(unsigned int m, Location *p) {
+    getLocation(m)->removeInfectedMosquito();
+    _locationID[m] = p->getID();
+    p->addInfectedMosquito();
+}
+
+
+void MosquitoPool::clear() {
+    _id.clear();
+    _locationID.clear();
+    _serotype.clear();
+    _ageInfected.clear();
+    _ageInfectious.clear();
+    _ageDeath.clear();
+    _freeList.clear();
 }
 
 
-Mosquito::Mosquito(RestoreMosquitoPars* rp):
-    _pLocation(rp->location), _eSerotype(rp->serotype), _nAgeInfected(rp->age_infected), _nAgeInfectious(rp->age_infectious), _nAgeDeath(rp->age_dead) {
-    _nID = _nNextID++;
-    _bDead = false;
-    _nInfectedAtID = -1;
-    _pOriginLocation = NULL;
-    _pLocation->addInfectedMosquito();
+void MosquitoPool::write(std::ostream& os) const {
+    snapshot::write(os, _id);
+    snapshot::write(os, _locationID);
+    snapshot::write(os, _serotype);
+    snapshot::write(os, _ageInfected);
+    snapshot::write(os, _ageInfectious);
+    snapshot::write(os, _ageDeath);
+    snapshot::write(os, _freeList);
+    snapshot::write(os, _nNextID);
 }
 
 
-Mosquito::~Mosquito() {
-    _pLocation->removeInfectedMosquito();
+void MosquitoPool::read(std::istream& is) {
+    snapshot::read(is, _id);
+    snapshot::read(is, _locationID);
+    snapshot::read(is, _serotype);
+    snapshot::read(is, _ageInfected);
+    snapshot::read(is, _ageInfectious);
+    snapshot::read(is, _ageDeath);
+    snapshot::read(is, _freeList);
+    snapshot::read(is, _nNextID);
 }
@@ -1,55 +1,87 @@
 // Mosquito.h
-// A single infected mosquito.
+// Infected mosquitoes.
 // This just takes care of mosquito lifespan, infecting serotype
 // Movement is handled by other classes (Community)
+//
+// Mosquitoes are stored in a MosquitoPool as parallel arrays (location, serotype, ages),
+// and are referred to by integer handles.  The slots of dead mosquitoes go on a free list
+// and are reused, so adding a mosquito does not allocate.
+//
+// The compartmental mosquito model instead keeps counts of indistinguishable mosquitoes
+// (MosquitoCohorts), which are queued by Community the same way individual mosquitoes are.
 #ifndef __MOSQUITO_H
 #define __MOSQUITO_H
+#include <vector>
+#include <tuple>
+#include <climits>
+#include <iostream>
 #include "Parameters.h"
 #include "Location.h" 
 
 class Location;
-//Location::removeInfectedMosquito();
-//Location::addInfectedMosquito();
 
 struct RestoreMosquitoPars {
-    RestoreMosquitoPars() : location(nullptr), serotype((Serotype) 0), age_infected(0), age_infectious(0), age_dead(0) {};
-    RestoreMosquitoPars(Location* l, Serotype s, int aid, int ais, int ad) : location(l), serotype(s), age_infected(aid), age_infectious(ais), age_dead(ad) {};
+    RestoreMosquitoPars() : location(nullptr), serotype((Serotype) 0), age_infected(0), age_infectious(0), age_dead(0), id(-1) {};
+    RestoreMosquitoPars(Location* l, Serotype s, int aid, int ais, int ad, int i = -1) : location(l), serotype(s), age_infected(aid), age_infectious(ais), age_dead(ad), id(i) {};
     Location* location;
     Serotype serotype;
     int age_infected;
     int age_infectious;
     int age_dead;
+    int id;                                                           // -1 to assign a new ID
 };
 
-class Mosquito {
+static const int ANONYMOUS_MOSQUITO_ID = INT_MAX;                     // infected-by ID for bites by mosquitoes in cohorts
+
+// Infected mosquitoes that share a location, serotype and remaining lifespan
+struct MosquitoCohort {
+    MosquitoCohort(int l, Serotype s, int di, int n) : locationID(l), serotype(s), daysInfectious(di), count(n) {};
+    int locationID;
+    Serotype serotype;
+    int daysInfectious;                                               // exposed cohorts: days left to live once infectious
+    int count;
+};
+
+inline bool operator<(const MosquitoCohort& lhs, const MosquitoCohort& rhs) {
+    return std::tie(lhs.locationID, lhs.serotype, lhs.daysInfectious) < std::tie(rhs.locationID, rhs.serotype, rhs.daysInfectious);
+}
+
+class MosquitoPool {
     public:
-        Mosquito();
-        Mosquito(Location* p, Serotype s, int nInfectedAtID, int nExternalIncubationPeriod, double prob_infecting_bite);
-        Mosquito(RestoreMosquitoPars* pars);
-
-        virtual ~Mosquito();
-        int getID() const { return _nID; }
-        Location* getLocation() const { return _pLocation; }
-        void setLocation(Location *p) { _pLocation = p; }
-        void updateLocation(Location *p) { _pLocation->removeInfectedMosquito(); setLocation(p); p->addInfectedMosquito(); }
-        Location* getOriginLocation() const { return _pOriginLocation; }
-        int getAgeInfected() const { return _nAgeInfected; }
-        int getAgeInfectious() const { return _nAgeInfectious; }
-        int getAgeDeath() const { return _nAgeDeath; }
-        bool isDead() const { return _bDead; }
-        Serotype getSerotype() const { return _eSerotype; }
-
-
-    protected:
-        int _nID;                                                     // unique identifier
-        Location* _pLocation;                                         // pointer to present location
-        Location* _pOriginLocation;                                   // pointer to origin (where infected) location
-        Serotype _eSerotype;                                          // infecting serotype
-        int _nAgeInfected;                                            // age when infected in days
-        int _nAgeInfectious;                                          // age when infectious in days
-        int _nAgeDeath;                                               // lifespan in days
-        bool _bDead;                                                  // is dead?
-        int _nInfectedAtID;                                           // location ID where infected
-        static int _nNextID;                                          // unique ID to assign to the next Mosquito allocated
+        // IDs are firstID, firstID + idStride, ...; pools with the same stride and different firstIDs assign disjoint IDs
+        MosquitoPool(const std::vector<Location*>& locations, int firstID = 0, int idStride = 1);
+        static void sampleAges(const gsl_rng* rng, double prob_infecting_bite, int &ageInfected, int &ageDeath); // ages at infection
+                                                                                                                 // and death, in days
+        unsigned int create(const gsl_rng* rng, Location* p, Serotype s, int nExternalIncubationPeriod, double prob_infecting_bite);
+        unsigned int restore(const RestoreMosquitoPars* pars);
+        void kill(unsigned int m);
+        void clear();                                                 // forgets all mosquitoes; location tallies are not updated
+        void write(std::ostream& os) const;                           // for a snapshot; handles are kept
+        void read(std::istream& is);
+
+        int getID(unsigned int m) const { return _id[m]; }
+        int getLocationID(unsigned int m) const { return _locationID[m]; }
+        Location* getLocation(unsigned int m) const { return _locations[_locationID[m]]; }
+        void updateLocation(unsigned int m, Location *p);
+        int getAgeInfected(unsigned int m) const { return _ageInfected[m]; }
+        int getAgeInfectious(unsigned int m) const { return _ageInfectious[m]; }
+        int getAgeDeath(unsigned int m) const { return _ageDeath[m]; }
+        Serotype getSerotype(unsigned int m) const { return _serotype[m]; }
+        unsigned int size() const { return _id.size() - _freeList.size(); } // number of living mosquitoes
+
+    private:
+        unsigned int _allocate();
+        int _newID() { const int id = _nNextID; _nNextID += _nIDStride; return id; }
+
+        const std::vector<Location*>& _locations;                    // location lookup; the array index is equal to the ID
+        std::vector<int> _id;                                         // unique identifier
+        std::vector<int> _locationID;                                 // ID of present location
+        std::vector<Serotype> _serotype;                              // infecting serotype
+        std::vector<int> _ageInfected;                                // age when infected in days
+        std::vector<int> _ageInfectious;                              // age when infectious in days
+        std::vector<int> _ageDeath;                                   // lifespan in days
+        std::vector<unsigned int> _freeList;                          // handles of dead mosquitoes, available for reuse
+        int _nNextID;                                                 // unique ID to assign to the next mosquito created
+        int _nIDStride;
 };
 #endif
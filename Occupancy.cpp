@@ -0,0 +1,129 @@
+// Occupancy.cpp
+
+#include <algorithm>
+#include "Parameters.h"
+#include "Occupancy.h"
+#include "Snapshot.h"
+
+using namespace std;
+
+const uint32_t Occupancy::NONE;
+
+// move row to the end of the flat array, with room for capacity occupants
+void Occupancy::_reserve(Row &row, int t, unsigned int capacity) {
+    assert(capacity >= row.size);
+    const uint32_t start = _occupant[t].size();
+    _occupant[t].resize(start + capacity);
+    _listingAt[t].resize(start + capacity);
+    copy(_occupant[t].begin() + row.start, _occupant[t].begin() + row.start + row.size, _occupant[t].begin() + start);
+    copy(_listingAt[t].begin() + row.start, _listingAt[t].begin() + row.start + row.size, _listingAt[t].begin() + start);
+    row.start = start;                                                // listings hold offsets within the row, so are still valid
+    row.capacity = capacity;
+}
+
+
+void Occupancy::add(unsigned int loc, unsigned int person, int t) {
+    assert(t >= 0 and t < (int) NUM_OF_TIME_PERIODS);
+    if (loc >= _row[t].size()) _row[t].resize(loc + 1);
+    if (person >= _firstListing[t].size()) _firstListing[t].resize(person + 1, NONE);
+
+    Row &row = _row[t][loc];
+    if (row.size == row.capacity) _reserve(row, t, max(4u, 2*row.capacity));
+
+    uint32_t k;
+    if (_freeListing[t].size() > 0) {
+        k = _freeListing[t].back();
+        _freeListing[t].pop_back();
+    } else {
+        k = _listing[t].size();
+        _listing[t].emplace_back();
+    }
+    _listing[t][k].location = loc;
+    _listing[t][k].offset = row.size;
+    _listing[t][k].next = _firstListing[t][person];
+    _firstListing[t][person] = k;
+
+    _occupant[t][row.start + row.size] = person;
+    _listingAt[t][row.start + row.size] = k;
+    row.size++;
+}
+
+
+bool Occupancy::remove(unsigned int loc, unsigned int person, int t) {
+    assert(t >= 0 and t < (int) NUM_OF_TIME_PERIODS);
+    if (person >= _firstListing[t].size()) return false;
+
+    // find person's listing at this location; people are rarely listed in more than one place at a time
+    uint32_t* link = &_firstListing[t][person];
+    while (*link != NONE and _listing[t][*link].location != loc) link = &_listing[t][*link].next;
+    if (*link == NONE) return false;
+    const uint32_t k = *link;
+    *link = _listing[t][k].next;
+
+    // fill the vacated position with the row's last occupant
+    Row &row = _row[t][loc];
+    const uint32_t pos = row.start + _listing[t][k].offset;
+    const uint32_t last = row.start + row.size - 1;
+    _occupant[t][pos] = _occupant[t][last];
+    _listingAt[t][pos] = _listingAt[t][last];
+    _listing[t][_listingAt[t][pos]].offset = pos - row.start;
+    row.size--;
+
+    _freeListing[t].push_back(k);
+    return true;
+}
+
+
+void Occupancy::pack() {
+    for (int t=0; t<(int) NUM_OF_TIME_PERIODS; t++) {
+        vector<uint32_t> occupant, listingAt;
+        for (Row &row: _row[t]) {
+            const uint32_t start = occupant.size();
+            const uint32_t capacity = row.size + row.size/4 + 1;       // some room for people staying home from work
+            occupant.resize(start + capacity);
+            listingAt.resize(start + capacity);
+            copy(_occupant[t].begin() + row.start, _occupant[t].begin() + row.start + row.size, occupant.begin() + start);
+            copy(_listingAt[t].begin() + row.start, _listingAt[t].begin() + row.start + row.size, listingAt.begin() + start);
+            row.start = start;
+            row.capacity = capacity;
+        }
+        _occupant[t].swap(occupant);
+        _listingAt[t].swap(listingAt);
+    }
+}
+
+
+void Occupancy::clear() {
+    for (int t=0; t<(int) NUM_OF_TIME_PERIODS; t++) {
+        _row[t].clear();
+        _occupant[t].clear();
+        _listingAt[t].clear();
+        _listing[t].clear();
+        _firstListing[t].clear();
+        _freeListing[t].clear();
+    }
+}
+
+
+void Occupancy::write(ostream& os) const {
+    for (int t = 0; t < (int) NUM_OF_TIME_PERIODS; t++) {
+        snapshot::write(os, _row[t]);
+        snapshot::write(os, _occupant[t]);
+        snapshot::write(os, _listingAt[t]);
+        snapshot::write(os, _listing[t]);
+        snapshot::write(os, _firstListing[t]);
+        snapshot::write(os, _freeListing[t]);
+    }
+}
+
+
+void Occupancy::read(istream& is) {
+    for (int t = 0; t < (int) NUM_OF_TIME_PERIODS; t++) {
+        snapshot::read(is, _row[t]);
+        snapshot::read(is, _occupant[t]);
+        snapshot::read(is, _listingAt[t]);
+        snapshot::read(is, _listing[t]);
+        snapshot::read(is, _firstListing[t]);
+        snapshot::read(is, _freeListing[t]);
+    }
+}
@@ -0,0 +1,56 @@
+// Occupancy.h
+// Who is at each location at each time of day.  For each time period, the occupants of every
+// location are a row of 32-bit person indices (IDs) in one flat array, as in a compressed sparse
+// row matrix.  Each listing remembers its position in its row, so people are added and removed in
+// O(1) by swapping with the row's last occupant.  A person may be listed more than once at the
+// same location and time (e.g., someone who withdraws to home again before returning to work).
+#ifndef __OCCUPANCY_H
+#define __OCCUPANCY_H
+#include <vector>
+#include <cstdint>
+#include <iostream>
+#include <assert.h>
+
+class Person;
+
+class Occupancy {
+    public:
+        Occupancy(const std::vector<Person*>& people) : _people(people) {}
+
+        void add(unsigned int loc, unsigned int person, int t);
+        bool remove(unsigned int loc, unsigned int person, int t);    // returns false if person is not listed there
+        unsigned int size(unsigned int loc, int t) const { return loc < _row[t].size() ? _row[t][loc].size : 0; }
+        unsigned int getPersonIndex(unsigned int loc, int t, unsigned int idx) const {
+            assert(idx < size(loc, t));
+            return _occupant[t][_row[t][loc].start + idx];
+        }
+        Person* getPerson(unsigned int loc, int t, unsigned int idx) const { return _people[getPersonIndex(loc, t, idx)]; }
+        void pack();                                                  // lay rows out contiguously, in location order
+        void clear();
+        void write(std::ostream& os) const;                           // every listing exactly as it is, so that
+        void read(std::istream& is);                                  // occupants are in the same order when read
+
+    private:
+        static const uint32_t NONE = UINT32_MAX;
+        struct Row {
+            Row() : start(0), size(0), capacity(0) {}
+            uint32_t start;                                           // position of the row in _occupant
+            uint32_t size;
+            uint32_t capacity;                                        // room reserved for the row before it must move
+        };
+        struct Listing {
+            uint32_t location;
+            uint32_t offset;                                          // position within the location's row
+            uint32_t next;                                            // person's next listing for this time period, or NONE
+        };
+        void _reserve(Row &row, int t, unsigned int capacity);
+
+        const std::vector<Person*>& _people;                          // resolves person indices
+        std::vector<Row> _row[NUM_OF_TIME_PERIODS];                   // indexed by location ID
+        std::vector<uint32_t> _occupant[NUM_OF_TIME_PERIODS];         // person indices, in rows
+        std::vector<uint32_t> _listingAt[NUM_OF_TIME_PERIODS];        // listing for each entry of _occupant
+        std::vector<Listing> _listing[NUM_OF_TIME_PERIODS];
+        std::vector<uint32_t> _firstListing[NUM_OF_TIME_PERIODS];     // indexed by person index
+        std::vector<uint32_t> _freeListing[NUM_OF_TIME_PERIODS];      // recycled entries of _listing
+};
+#endif
@@ -1,9 +1,11 @@
 #include "Parameters.h"
 #include "Location.h"
 #include "Utility.h"
+#include "RandomStreams.h"
 #include <fstream>
 #include <sstream>
 #include <numeric>
+#include <algorithm>
 #include <gsl/gsl_randist.h>
 #include <gsl/gsl_errno.h>
 #include <gsl/gsl_math.h>
@@ -21,6 +23,12 @@ void Parameters::define_defaults() {
     fMosquitoMove = 0.2;
     mosquitoMoveModel = "weighted";
     fMosquitoTeleport = 0.0;
+    eMosquitoModel = INDIVIDUAL_MOSQUITOES;
+    eMosquitoBiteModel = BERNOULLI_BITES;
+    nSpatialTiles = 1;
+    nThreads = 1;
+    nFirstCore = -1;
+    nReplicates = 1;
     fVESs = vector<double>(NUM_OF_SEROTYPES, 0.7);
     fVESs_NAIVE.clear();
     fVEI = 0.0;
@@ -42,10 +50,15 @@ void Parameters::define_defaults() {
     peopleOutputFilename = "";
     yearlyPeopleOutputFilename = "";
     dailyOutputFilename = "";
+    restoreFilename = "";
+    snapshotCacheDirectory = "";
+    snapshotCacheMegabytes = 10240;
+    snapshotCacheKey = "";
     swapProbFilename = "";
     annualIntroductionsFilename = "";                   // time series of some external factor determining introduction rate
     annualIntroductionsCoef = 1;                        // multiplier to rescale external introductions to something sensible
     normalizeSerotypeIntros = false;
+    simulateAnnualSerotypes = false;
     annualIntroductions = {1.0};
     nDaysImmune = 365;
     reportedFraction = {0.0, 0.05, 1.0};                // fraction of asymptomatic, mild, and severe cases reported
@@ -119,9 +132,15 @@ void Parameters::readParameters(int argc, char* argv[]) {
     cerr << "Dengue model, Version " << VERSION_NUMBER_MAJOR << "." << VERSION_NUMBER_MINOR << endl;
     cerr << "written by Dennis Chao and Thomas Hladish in 2012-2014" << endl;
 
+    // options that do not change what is simulated up to any given day, and so are left out of snapshotCacheKey
+    static const set<string> outputOptions = { "-threads", "-pinthreads", "-replicates", "-peopleoutputfile", "-yearlypeopleoutputfile",
+                                               "-dailyoutputfile", "-snapshot", "-restore", "-snapshotcache", "-snapshotcachedays",
+                                               "-dailyoutput", "-weeklyoutput", "-monthlyoutput", "-yearlyoutput", "-abcverbose", "-runlength" };
+    vector<string> keyOptions;                              // each option with its values, as given
     if (argc>1) {
         for (int i=1; i<argc; i++) {
             char** end = NULL;
+            const int option = i;
             if (strcmp(argv[i], "-randomseed")==0) {
                 randomseed = strtol(argv[++i],end,10);
             }
@@ -160,6 +179,40 @@ void Parameters::readParameters(int argc, char* argv[]) {
             else if (strcmp(argv[i], "-mosquitoteleport")==0) {
                 fMosquitoTeleport = strtod(argv[++i],end);
             }
+            else if (strcmp(argv[i], "-mosquitomodel")==0) {
+                const char* argstr = {argv[++i]};
+                if (strcmp(argstr, "individual")==0) {
+                    eMosquitoModel = INDIVIDUAL_MOSQUITOES;
+                } else if (strcmp(argstr, "compartmental")==0) {
+                    eMosquitoModel = COMPARTMENTAL_MOSQUITOES;
+                } else {
+                    cerr << "ERROR: Invalid mosquito model specified." << endl;
+                    exit(-1);
+                }
+            }
+            else if (strcmp(argv[i], "-mosquitobitemodel")==0) {
+                const char* argstr = {argv[++i]};
+                if (strcmp(argstr, "bernoulli")==0) {
+                    eMosquitoBiteModel = BERNOULLI_BITES;
+                } else if (strcmp(argstr, "binomial")==0) {
+                    eMosquitoBiteModel = BINOMIAL_BITES;
+                } else {
+                    cerr << "ERROR: Invalid mosquito bite model specified." << endl;
+                    exit(-1);
+                }
+            }
+            else if (strcmp(argv[i], "-spatialtiles")==0) {
+                nSpatialTiles = strtol(argv[++i],end,10);
+            }
+            else if (strcmp(argv[i], "-threads")==0) {
+                nThreads = strtol(argv[++i],end,10);
+            }
+            else if (strcmp(argv[i], "-pinthreads")==0) {
+                nFirstCore = strtol(argv[++i],end,10);
+            }
+            else if (strcmp(argv[i], "-replicates")==0) {
+                nReplicates = strtol(argv[++i],end,10);
+            }
             else if (strcmp(argv[i], "-mosquitocapacity")==0) {
                 nDefaultMosquitoCapacity = strtol(argv[++i],end,10);
             }
@@ -254,6 +307,21 @@ void Parameters::readParameters(int argc, char* argv[]) {
             else if (strcmp(argv[i], "-dailyoutputfile")==0) {
                 dailyOutputFilename = argv[++i];
             }
+            else if (strcmp(argv[i], "-snapshot")==0) {
+                const int day = strtol(argv[++i],end,10);
+                snapshotFilenames[day] = argv[++i];
+            }
+            else if (strcmp(argv[i], "-restore")==0) {
+                restoreFilename = argv[++i];
+            }
+            else if (strcmp(argv[i], "-snapshotcache")==0) {
+                snapshotCacheDirectory = argv[++i];
+                snapshotCacheMegabytes = strtod(argv[++i],end);
+            }
+            else if (strcmp(argv[i], "-snapshotcachedays")==0) {
+                const int n = strtol(argv[++i],end,10);
+                for (int j=0; j<n; j++) snapshotCacheDays.insert(strtol(argv[++i],end,10));
+            }
             else if (strcmp(argv[i], "-probfile")==0) {
                 swapProbFilename = argv[++i];
             }
@@ -295,10 +363,19 @@ void Parameters::readParameters(int argc, char* argv[]) {
                 cerr << "Check arguments and formatting." << endl;
                 exit(-1);
             }
+            if (outputOptions.count(argv[option]) == 0) {
+                string given;
+                for (int j=option; j<=i; j++) given += string(argv[j]) + " ";
+                keyOptions.push_back(given);
+            }
         }
     }
+    // sorted by name, so the order the options are given in does not matter, except among repeats of one option
+    stable_sort(keyOptions.begin(), keyOptions.end(), [](const string& a, const string& b) { return a.substr(0, a.find(' ')) < b.substr(0, b.find(' ')); });
+    for (const string& given: keyOptions) snapshotCacheKey += given;
+    // but every year's simulated serotypes depend on how many years are simulated (see generateAnnualSerotypes())
+    if (simulateAnnualSerotypes) snapshotCacheKey += "-runlength " + to_string(nRunLength) + " ";
 
-    gsl_rng_set(RNG, randomseed);
     // runlength and randomseed need to be set before calling generateAnnualSerotypes()
     if (simulateAnnualSerotypes) generateAnnualSerotypes();
     validate_parameters();
@@ -324,6 +401,27 @@ void Parameters::validate_parameters() {
         exit(-1);
     }
     cerr << "mosquito teleport prob = " << fMosquitoTeleport << endl;
+    cerr << "mosquito model = " << (eMosquitoModel==COMPARTMENTAL_MOSQUITOES ? "compartmental" : "individual") << endl;
+    cerr << "mosquito bite model = " << (eMosquitoBiteModel==BINOMIAL_BITES ? "binomial" : "bernoulli") << endl;
+    cerr << "spatial tiles = " << nSpatialTiles << endl;
+    cerr << "threads = " << nThreads << endl;
+    if (nSpatialTiles < 1 or nThreads < 1) {
+        cerr << "ERROR: -spatialtiles and -threads must be at least 1" << endl;
+        exit(-1);
+    }
+    if (nFirstCore >= 0) {
+        cerr << "threads pinned to cores " << nFirstCore << "-" << nFirstCore + nThreads - 1 << endl;
+    }
+    if (nReplicates < 1) {
+        cerr << "ERROR: -replicates must be at least 1" << endl;
+        exit(-1);
+    }
+    if (nReplicates > 1) {
+        cerr << "replicates = " << nReplicates << " (random seeds " << randomseed << "-" << randomseed + nReplicates - 1 << ")" << endl;
+    }
+    if (nThreads > nSpatialTiles) {
+        cerr << "WARNING: more threads than spatial tiles; only " << nSpatialTiles << " thread(s) will be used" << endl;
+    }
     cerr << "default mosquito capacity per building = " << nDefaultMosquitoCapacity << endl;
     if (annualSerotypeFilename == "") {
         cerr << "number of daily exposures / serotype weights =";
@@ -414,6 +512,30 @@ void Parameters::validate_parameters() {
     } else {
         cerr << "no daily output file" << endl;
     }
+    for (const auto &snapshot: snapshotFilenames) {
+        cerr << "snapshot of day " << snapshot.first << " = " << snapshot.second << endl;
+        if (snapshot.first < 0 or snapshot.first >= nRunLength) {
+            cerr << "ERROR: snapshots must be of days 0 to " << nRunLength - 1 << endl;
+            exit(-1);
+        }
+    }
+    if (restoreFilename.length()>0) {
+        cerr << "restore from snapshot = " << restoreFilename << endl;
+    }
+    if (snapshotCacheDirectory.length()>0) {
+        cerr << "snapshot cache = " << snapshotCacheDirectory << " (up to " << snapshotCacheMegabytes << " MB)" << endl;
+        cerr << "cached snapshot days =";
+        for (int day: snapshotCacheDays) cerr << " " << day;
+        cerr << endl;
+        if (snapshotCacheMegabytes <= 0) {
+            cerr << "ERROR: the snapshot cache's size limit must be positive" << endl;
+            exit(-1);
+        }
+    }
+    if ((snapshotFilenames.size() > 0 or restoreFilename.length() > 0 or snapshotCacheDirectory.length() > 0) and nReplicates > 1) {
+        cerr << "ERROR: -snapshot, -restore and -snapshotcache are not supported with -replicates" << endl;
+        exit(-1);
+    }
 }
 
 
@@ -494,8 +616,11 @@ void Parameters::writeAnnualSerotypes(string filename) const {
 }
 
 
+// Serotype runs are drawn from a setup stream of randomseed's own, so they depend only on the seed, and not on
+// any generator shared with other simulations
 void Parameters::generateAnnualSerotypes(int total_num_years) { // default arg value is -1
     enum State {GAP, RUN};
+    gsl_rng* rng = RandomStreams::alloc(randomseed, SETUP_RNG, SEROTYPE_RUN_SUBSTREAM);
     // get rid of anything there now
     for (auto &v: nDailyExposed) v.clear();
     nDailyExposed.clear();
@@ -511,21 +636,21 @@ void Parameters::generateAnnualSerotypes(int total_num_years) { // default arg v
         const float p_gap_start = MEAN_GAP_LENGTH[s]/(MEAN_GAP_LENGTH[s] + MEAN_RUN_LENGTH[s]);
 
         int years_so_far = 0;
-        State state = p_gap_start > gsl_rng_uniform(RNG) ? GAP : RUN;
+        State state = p_gap_start > gsl_rng_uniform(rng) ? GAP : RUN;
         while (years_so_far < total_num_years) {
             if (state == GAP) {
-                unsigned int gap = gsl_ran_geometric(RNG, p_gap);
+                unsigned int gap = gsl_ran_geometric(rng, p_gap);
                 // We may not be starting at the beginning of a gap
                 // Also: gsl_rng_uniform_int() returns ints on [0,n-1]
-                if (years_so_far == 0) gap = gsl_rng_uniform_int(RNG, gap) + 1;
+                if (years_so_far == 0) gap = gsl_rng_uniform_int(rng, gap) + 1;
                 while (gap > 0 and (unsigned) years_so_far < nDailyExposed.size()) {
                     nDailyExposed[years_so_far++][s] = 0.0;
                     --gap;
                 }
                 state = RUN;
             } else {
-                unsigned int run = gsl_ran_geometric(RNG, p_run);
-                if (years_so_far == 0) run = gsl_rng_uniform_int(RNG, run) + 1;
+                unsigned int run = gsl_ran_geometric(rng, p_run);
+                if (years_so_far == 0) run = gsl_rng_uniform_int(rng, run) + 1;
                 while (run > 0 and (unsigned) years_so_far < nDailyExposed.size()) {
                     nDailyExposed[years_so_far++][s] = 1.0;
                     --run;
@@ -534,6 +659,7 @@ void Parameters::generateAnnualSerotypes(int total_num_years) { // default arg v
             }
         }
     }
+    gsl_rng_free(rng);
     if (not abcVerbose) {
         cerr << "Serotype runs:" << endl;
         for (auto &y: nDailyExposed) {
@@ -31,6 +31,18 @@ enum MosquitoDistribution {
     NUM_OF_DISTRIBUTIONS
 };
 
+enum MosquitoModel {
+    INDIVIDUAL_MOSQUITOES,                                  // each infected mosquito is simulated
+    COMPARTMENTAL_MOSQUITOES,                               // counts of infected mosquitoes, with binomial draws
+    NUM_OF_MOSQUITO_MODELS
+};
+
+enum MosquitoBiteModel {
+    BERNOULLI_BITES,                                        // one draw per infectious mosquito per day
+    BINOMIAL_BITES,                                         // one draw per location and serotype per day
+    NUM_OF_MOSQUITO_BITE_MODELS
+};
+
 enum TimePeriod {
     HOME_MORNING,
     WORK_DAY,
@@ -306,6 +318,12 @@ public:
     double fMosquitoMove;                                   // daily probability of mosquito migration
     std::string mosquitoMoveModel;                          // weighted or uniform mosquito movement to adj. buildings
     double fMosquitoTeleport;                               // daily probability of mosquito teleportation (long-range movement)
+    MosquitoModel eMosquitoModel;                           // individual mosquitoes, or counts per location (compartmental)
+    MosquitoBiteModel eMosquitoBiteModel;                   // how the number of infectious bites is sampled
+    int nSpatialTiles;                                      // locations are split into this many tiles, simulated in parallel
+    int nThreads;                                           // threads per community (including the calling thread)
+    int nFirstCore;                                         // thread t is pinned to core nFirstCore+t; -1 if not pinned
+    int nReplicates;                                        // simulated together, with seeds randomseed, randomseed+1, ...
     std::vector<double> fVESs;                              // vaccine efficacy for susceptibility (can be leaky or all-or-none)
     std::vector<double> fVESs_NAIVE;                        // VES for initially immunologically naive people
     double fVEI;                                            // vaccine efficacy to reduce infectiousness
@@ -352,6 +370,16 @@ public:
     std::string peopleOutputFilename;
     std::string yearlyPeopleOutputFilename;
     std::string dailyOutputFilename;
+    std::map<int, std::string> snapshotFilenames;           // snapshots to write, by the day at whose start they are taken
+    std::string restoreFilename;                            // snapshot to continue from, if any
+    std::string snapshotCacheDirectory;                     // snapshot cache (see SnapshotCache in simulator.h), if any
+    double snapshotCacheMegabytes;                          // size limit of the cache
+    std::set<int> snapshotCacheDays;                        // days at whose start snapshots are cached
+    std::string snapshotCacheKey;                           // the options that determine a simulation: all but the run
+                                                            // length and those that only affect output or speed, sorted
+                                                            // by name.  set by readParameters(); must be set by any
+                                                            // program that sets parameters itself (the cache adds the
+                                                            // vector control and vaccinations; see SnapshotCache)
     std::string swapProbFilename;
     std::string annualIntroductionsFilename;                // time series of some external factor determining introduction rate
     std::string annualSerotypeFilename;                     // time series of some external factor determining introduction rate
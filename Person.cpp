@@ -16,20 +16,16 @@
 #include "Person.h"
 #include "Community.h"
 #include "Parameters.h"
+#include "Snapshot.h"
 
 using namespace dengue::standard;
 
-int Person::_nNextID = 0;
-
-const Parameters* Person::_par;
-
-Person::Person() {
-    _nID = _nNextID++;
-    _nAge = -1;
-    _nLifespan = -1;
-    _nHomeID = -1;
-    _nWorkID = -1;
-    for(int i=0; i<(int) NUM_OF_TIME_PERIODS; i++) _pLocation[i] = NULL;
+Person::Person(Community* community, int id, const PersonAttributes* attributes, const vector<Location*>* locations) {
+    _community = community;
+    _par = community->getPar();
+    _nID = id;
+    _attributes = attributes;
+    _locations = locations;
     _bDead = false;
     _bVaccinated = false;
     _bNaiveVaccineProtection = false;
@@ -56,11 +52,16 @@ Infection& Person::initializeNewInfection(Serotype serotype) {
 
 
 Infection& Person::initializeNewInfection(Serotype serotype, int time, int sourceloc, int sourceid) {
+    return initializeNewInfection(serotype, time, sourceloc, sourceid, _community->getRNG(HUMAN_INFECTION_RNG));
+}
+
+
+Infection& Person::initializeNewInfection(Serotype serotype, int time, int sourceloc, int sourceid, const gsl_rng* rng) {
     Infection& infection = initializeNewInfection(serotype);
     infection.infectedTime  = time;
     infection.infectedPlace = sourceloc;
     infection.infectedByID  = sourceid; // TODO - What kind of ID is this?
-    infection.infectiousTime = Parameters::sampler(INCUBATION_CDF, gsl_rng_uniform(RNG)) + time;
+    infection.infectiousTime = Parameters::sampler(INCUBATION_CDF, gsl_rng_uniform(rng)) + time;
     return infection;
 }
 
@@ -92,8 +93,52 @@ void Person::resetImmunity() {
 }
 
 
+// everything that can change during a simulation (see Community::writeSnapshot())
+void Person::write(std::ostream& os) const {
+    snapshot::write(os, (uint32_t) _nImmunity.to_ulong());
+    snapshot::write(os, _bDead);
+    snapshot::write(os, _bVaccinated);
+    snapshot::write(os, _bNaiveVaccineProtection);
+    snapshot::write(os, vaccineHistory);
+    snapshot::write(os, (uint32_t) infectionHistory.size());
+    for (const Infection* infection: infectionHistory) {              // field by field, so no padding is written
+        for (int time: {infection->infectedByID, infection->infectedPlace, infection->infectedTime, infection->infectiousTime,
+                        infection->symptomTime, infection->recoveryTime, infection->withdrawnTime}) snapshot::write(os, time);
+        snapshot::write(os, infection->_serotype);
+        snapshot::write(os, infection->severeDisease);
+    }
+}
+
+
+void Person::read(std::istream& is) {
+    uint32_t immunity = 0;
+    snapshot::read(is, immunity);
+    _nImmunity = std::bitset<NUM_OF_SEROTYPES>(immunity);
+    snapshot::read(is, _bDead);
+    snapshot::read(is, _bVaccinated);
+    snapshot::read(is, _bNaiveVaccineProtection);
+    snapshot::read(is, vaccineHistory);
+    uint32_t n = 0;
+    snapshot::read(is, n);
+    clearInfectionHistory();
+    for (uint32_t i = 0; i < n and is; i++) {
+        Infection* infection = new Infection();
+        for (int* time: {&infection->infectedByID, &infection->infectedPlace, &infection->infectedTime, &infection->infectiousTime,
+                         &infection->symptomTime, &infection->recoveryTime, &infection->withdrawnTime}) snapshot::read(is, *time);
+        snapshot::read(is, infection->_serotype);
+        snapshot::read(is, infection->severeDisease);
+        infectionHistory.push_back(infection);
+    }
+}
+
+
+void Person::updateParameters() {
+    _par = _community->getPar();
+}
+
+
 bool Person::naturalDeath(int t) {
-    if (_nLifespan<=_nAge+(t/365.0)) {
+    if (getLifespan()<=getAge()+(t/365.0)) {
         _bDead = true;
         return true;
     }
@@ -107,9 +152,14 @@ void Person::kill() {
 
 
 bool Person::isInfectable(Serotype serotype, int time) const {
+    return isInfectable(serotype, time, _community->getRNG(HUMAN_INFECTION_RNG));
+}
+
+
+bool Person::isInfectable(Serotype serotype, int time, const gsl_rng* rng) const {
     return isSusceptible(serotype) and // is susceptible to this serotype (i.e., not immune to this serotype via previous infection)
            !isCrossProtected(time) and // not cross-serotype protection from last infection
-           !isVaccineProtected(serotype, time); // not vaccine protected at this time
+           !isVaccineProtected(serotype, time, rng); // not vaccine protected at this time
 }
 
 
@@ -153,14 +203,14 @@ double Person::vaccineProtection(const Serotype serotype, const int time) const
 
 enum MaternalEffect { MATERNAL_PROTECTION, NO_EFFECT, MATERNAL_ENHANCEMENT };
 
-MaternalEffect _maternal_antibody_effect(Person* p, const Parameters* _par, int time) {
+MaternalEffect _maternal_antibody_effect(Person* p, const Parameters* _par, const gsl_rng* rng, int time) {
     MaternalEffect effect = NO_EFFECT;
     if (p->getAge() == 0 and time >= 0) {                       // this is an infant, and we aren't reloading an infection history
-        Person* mom = p->getLocation(HOME_NIGHT)->findMom();    // find a cohabitating female of reproductive age
+        Person* mom = p->getLocation(HOME_NIGHT)->findMom(rng);    // find a cohabitating female of reproductive age
         if (mom and mom->getImmunityBitset().any()) {           // if there is one and she has an infection history
-            if (gsl_rng_uniform(RNG) < _par->infantImmuneProb) {
+            if (gsl_rng_uniform(rng) < _par->infantImmuneProb) {
                 effect = MATERNAL_PROTECTION;
-            } else if (gsl_rng_uniform(RNG) < _par->infantSevereProb) {
+            } else if (gsl_rng_uniform(rng) < _par->infantSevereProb) {
                 effect = MATERNAL_ENHANCEMENT;
             }
         }
@@ -175,11 +225,18 @@ MaternalEffect _maternal_antibody_effect(Person* p, const Parameters* _par, int
 // if secondaryPathogenicityOddsRatio > 1, secondary infections are more often symptomatic
 // returns true if infection occurs
 bool Person::infect(int sourceid, Serotype serotype, int time, int sourceloc) {
+    if (not acquireInfection(sourceid, serotype, time, sourceloc, _community->getRNG(HUMAN_INFECTION_RNG))) return false;
+    _community->flagNewInfection(this);
+    return true;
+}
+
+
+bool Person::acquireInfection(int sourceid, Serotype serotype, int time, int sourceloc, const gsl_rng* rng) {
     // Bail now if this person can not become infected
     // TODO - clarify this.  why would a person not be infectable in this scope?
-    if (not isInfectable(serotype, time)) return false;
+    if (not isInfectable(serotype, time, rng)) return false;
 
-    MaternalEffect maternal_effect = _maternal_antibody_effect(this, _par, time);
+    MaternalEffect maternal_effect = _maternal_antibody_effect(this, _par, rng, time);
     bool maternalAntibodyEnhancement;
     switch( maternal_effect ) {
         case MATERNAL_PROTECTION:
@@ -201,7 +258,7 @@ bool Person::infect(int sourceid, Serotype serotype, int time, int sourceloc) {
     const double remaining_efficacy = remainingEfficacy(time);  // before initializing new infection
 
     // Create a new infection record
-    Infection& infection = initializeNewInfection(serotype, time, sourceloc, sourceid);
+    Infection& infection = initializeNewInfection(serotype, time, sourceloc, sourceid, rng);
 
     double symptomatic_probability = _par->serotypePathogenicityRelativeRisks[(int) serotype] * _par->basePathogenicity;
     double severe_given_case = 0.0;
@@ -210,7 +267,7 @@ bool Person::infect(int sourceid, Serotype serotype, int time, int sourceloc) {
             if (_par->primaryPathogenicityModel == CONSTANT_PATHOGENICITY) {
                 symptomatic_probability *= _par->primaryRelativeRisk;
             } else if (_par->primaryPathogenicityModel == ORIGINAL_LOGISTIC) {
-                symptomatic_probability *= SYMPTOMATIC_BY_AGE[_nAge];
+                symptomatic_probability *= SYMPTOMATIC_BY_AGE[getAge()];
             } else if (_par->primaryPathogenicityModel == GEOMETRIC_PATHOGENICITY) {
                 symptomatic_probability *= 1.0 - pow(1.0 - _par->annualFlavivirusAttackRate, getAge());
             }
@@ -245,11 +302,11 @@ bool Person::infect(int sourceid, Serotype serotype, int time, int sourceloc) {
 
     infection.recoveryTime = infection.infectiousTime + INFECTIOUS_PERIOD_ASYMPTOMATIC;            // may be changed below 
 
-    if ((gsl_rng_uniform(RNG) < symptomatic_probability) or maternalAntibodyEnhancement) {         // Is this a case?
-        const double severe_rand = gsl_rng_uniform(RNG);
+    if ((gsl_rng_uniform(rng) < symptomatic_probability) or maternalAntibodyEnhancement) {         // Is this a case?
+        const double severe_rand = gsl_rng_uniform(rng);
         infection.recoveryTime = infection.infectiousTime + INFECTIOUS_PERIOD_MILD;                // may yet be changed below 
         if ( severe_rand < severe_given_case or maternalAntibodyEnhancement) {                     // Is this a severe case?
-            if (not isVaccinated() or gsl_rng_uniform(RNG) > _par->fVEH*remaining_efficacy) { // Is this person unvaccinated or vaccinated but unlucky?
+            if (not isVaccinated() or gsl_rng_uniform(rng) > _par->fVEH*remaining_efficacy) { // Is this person unvaccinated or vaccinated but unlucky?
                 infection.recoveryTime = infection.infectiousTime + INFECTIOUS_PERIOD_SEVERE;
                 infection.severeDisease = true;
             }
@@ -258,20 +315,12 @@ bool Person::infect(int sourceid, Serotype serotype, int time, int sourceloc) {
         // Determine if this person withdraws (stops going to work/school)
         infection.symptomTime = infection.infectiousTime + SYMPTOMATIC_DELAY;
         const int symptomatic_duration = infection.recoveryTime - infection.symptomTime;
-        const int symptomatic_active_period = gsl_ran_geometric(RNG, 0.5) - 1; // min generator value is 1 trial
+        const int symptomatic_active_period = gsl_ran_geometric(rng, 0.5) - 1; // min generator value is 1 trial
         infection.withdrawnTime = symptomatic_active_period < symptomatic_duration ?
                                   infection.symptomTime + symptomatic_active_period :
                                   infection.withdrawnTime;
     }
 
-    // Flag locations with (non-historical) infections, so that we know to look there for human->mosquito transmission
-    // Negative days are historical (pre-simulation) events, and thus we don't care about modeling transmission
-    for (int day = std::max(infection.infectiousTime, 0); day < infection.recoveryTime; day++) {
-        for (int t=0; t<(int) NUM_OF_TIME_PERIODS; t++) {
-            Community::flagInfectedLocation(_pLocation[t], day);
-        }
-    }
-
     // if the antibody-primed vaccine-induced immunity can be acquired retroactively, upgrade this person from naive to mature
     if (_par->bRetroactiveMatureVaccine) _bNaiveVaccineProtection = false;
 
@@ -358,9 +407,14 @@ bool Person::isCrossProtected(int time) const {
 
 
 bool Person::isVaccineProtected(Serotype serotype, int time) const {
+    return isVaccineProtected(serotype, time, _community->getRNG(HUMAN_INFECTION_RNG));
+}
+
+
+bool Person::isVaccineProtected(Serotype serotype, int time, const gsl_rng* rng) const {
     return isVaccinated() and
            ( !_par->bVaccineLeaky or // if the vaccine isn't leaky
-            (gsl_rng_uniform(RNG) < vaccineProtection(serotype, time)) ); // or it protects (i.e., doesn't leak this time)
+            (gsl_rng_uniform(rng) < vaccineProtection(serotype, time)) ); // or it protects (i.e., doesn't leak this time)
 }
 
 
@@ -382,8 +436,8 @@ bool Person::isSeroEligible(VaccineSeroConstraint vsc, double falsePos, double f
 
     bool isSeroPos = not fullySusceptible(); // fully susceptible == seronegative == false
 
-    if ((isSeroPos and (falseNeg > gsl_rng_uniform(RNG)))       // sero+ but tests negative
-        or (!isSeroPos and (falsePos > gsl_rng_uniform(RNG)))) { // sero- but tests positive
+    if ((isSeroPos and (falseNeg > gsl_rng_uniform(_community->getRNG(VACCINATION_RNG))))       // sero+ but tests negative
+        or (!isSeroPos and (falsePos > gsl_rng_uniform(_community->getRNG(VACCINATION_RNG))))) { // sero- but tests positive
         isSeroPos = !isSeroPos;
     }
 
@@ -406,11 +460,11 @@ bool Person::vaccinate(int time) {
         if ( _par->bVaccineLeaky == false ) { // all-or-none VE_S protection
             if ( fullySusceptible() ) { // naive against all serotypes
                 for (int i=0; i<NUM_OF_SEROTYPES; i++) {
-                    if (gsl_rng_uniform(RNG)<_par->fVESs_NAIVE[i]) _nImmunity[i] = 1;                                // protect against serotype i
+                    if (gsl_rng_uniform(_community->getRNG(VACCINATION_RNG))<_par->fVESs_NAIVE[i]) _nImmunity[i] = 1;                                // protect against serotype i
                 }
             } else {
                 for (int i=0; i<NUM_OF_SEROTYPES; i++) {
-                    if (gsl_rng_uniform(RNG)<_par->fVESs[i]) _nImmunity[i] = 1;                                // protect against serotype i
+                    if (gsl_rng_uniform(_community->getRNG(VACCINATION_RNG))<_par->fVESs[i]) _nImmunity[i] = 1;                                // protect against serotype i
                 }
             }
         }
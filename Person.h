@@ -6,10 +6,13 @@
 #include <bitset>
 #include <vector>
 #include <climits>
+#include <iostream>
+#include <gsl/gsl_rng.h>
 #include "Parameters.h"
 #include "Location.h"
 
 class Location;
+class Community;
 
 class Infection {
     friend class Person;
@@ -70,35 +73,46 @@ class Infection {
     Serotype serotype()  const { return _serotype; }
 };
 
+// What the population file says about a person, which never changes during a run.  Replicates of a
+// community share one copy of these (see Community.h).
+struct PersonAttributes {
+    PersonAttributes() : homeID(-1), workID(-1), age(-1), sex(UNKNOWN), lifespan(-1) {
+        for (int i=0; i<(int) NUM_OF_TIME_PERIODS; i++) location[i] = -1;
+    }
+    int homeID;                                                       // family membership
+    int workID;                                                       // ID of location of work
+    int location[(int) NUM_OF_TIME_PERIODS];                          // location IDs at morning, day, and evening
+    int age;                                                          // age in years
+    SexType sex;                                                      // sex (gender)
+    int lifespan;                                                     // lifespan in years
+};
+
 class Person {
     public:
-        Person();
+                                                                      // locations resolves the location IDs in attributes
+        Person(Community* community, int id, const PersonAttributes* attributes, const std::vector<Location*>* locations);
         ~Person();
         inline int getID() const { return _nID; }
-        int getAge() const { return _nAge; }
-        void setAge(int n) { _nAge = n; }
-        SexType getSex() const { return _sex; }
-        void setSex(SexType sex) { _sex = sex; }
-        int getLifespan() const { return _nLifespan; }
-        void setLifespan(int n) { _nLifespan = n; }
-        int getHomeID() const { return _nHomeID; }
-        void setHomeID(int n) { _nHomeID = n; }
-        int getWorkID() const { return _nWorkID; }
-        void setWorkID(int n) { _nWorkID = n; }
+        int getAge() const { return _attributes->age; }
+        SexType getSex() const { return _attributes->sex; }
+        int getLifespan() const { return _attributes->lifespan; }
+        int getHomeID() const { return _attributes->homeID; }
+        int getWorkID() const { return _attributes->workID; }
         void setImmunity(Serotype serotype) { _nImmunity[(int) serotype] = 1; }
         const std::bitset<NUM_OF_SEROTYPES> getImmunityBitset() const { return _nImmunity; }
         const std::string getImmunityString() const { return _nImmunity.to_string(); }
         void copyImmunity(const Person *p);
         void resetImmunity();
-        void appendToSwapProbabilities(std::pair<int, double> p) { _swap_probabilities.push_back(p); }
-        std::vector<std::pair<int, double> > getSwapProbabilities() const { return _swap_probabilities; }
+        void updateParameters();                                     // after the community is restarted with new parameters
+        void write(std::ostream& os) const;                           // immune state and history, for a snapshot
+        void read(std::istream& is);
 
         bool isSusceptible(Serotype serotype) const;                  // is susceptible to serotype (and is alive)
         bool isCrossProtected(int time) const;
         bool isVaccineProtected(Serotype serotype, int time) const;
+        bool isVaccineProtected(Serotype serotype, int time, const gsl_rng* rng) const;
 
-        inline Location* getLocation(TimePeriod timeofday) const { return _pLocation[(int) timeofday]; }
-        inline void setLocation(Location* p, TimePeriod timeofday) { _pLocation[(int) timeofday] = p; }
+        inline Location* getLocation(TimePeriod timeofday) const { return (*_locations)[_attributes->location[(int) timeofday]]; }
 
         inline int getInfectedByID(int infectionsago=0) const    { return getInfection(infectionsago)->infectedByID; }
         inline int getInfectedPlace(int infectionsago=0) const   { return getInfection(infectionsago)->infectedPlace; }
@@ -131,6 +145,11 @@ class Person {
 
         bool infect(int sourceid, Serotype serotype, int time, int sourceloc);
         inline bool infect(Serotype serotype, int time) {return infect(INT_MIN, serotype, time, INT_MIN);}
+                                                                      // infect() without telling the community: draws only
+                                                                      // from rng and changes only this person, so different
+                                                                      // people can be infected on different threads.  the
+                                                                      // caller must then call Community::flagNewInfection()
+        bool acquireInfection(int sourceid, Serotype serotype, int time, int sourceloc, const gsl_rng* rng);
         bool isViremic(int time) const;
 
         void kill();
@@ -145,6 +164,7 @@ class Person {
             return _bVaccinated;
         }
         bool isInfectable(Serotype serotype, int time) const;         // more complicated than isSusceptible
+        bool isInfectable(Serotype serotype, int time, const gsl_rng* rng) const;
         double remainingEfficacy(const int time) const;
 
         bool fullySusceptible() const;
@@ -152,34 +172,27 @@ class Person {
                                                                       // NB: inaccurate test results are possible
         bool isSeroEligible(VaccineSeroConstraint vsc, double falsePos, double falseNeg) const;
         bool vaccinate(int time);                                     // vaccinate this person
-        static void setPar(const Parameters* par) { _par = par; }
 
         static const double _fIncubationDistribution[MAX_INCUBATION];
 
         Infection& initializeNewInfection(Serotype serotype);
         Infection& initializeNewInfection(Serotype serotype, int time, int sourceloc, int sourceid);
-
-        static void reset_ID_counter() { _nNextID = 1; }
+        Infection& initializeNewInfection(Serotype serotype, int time, int sourceloc, int sourceid, const gsl_rng* rng);
 
     protected:
         int _nID;                                                     // unique identifier
-        int _nHomeID;                                                 // family membership
-        int _nWorkID;                                                 // ID of location of work
-        Location *_pLocation[(int) NUM_OF_TIME_PERIODS];              // where this person is at morning, day, and evening
-        int _nAge;                                                    // age in years
-        SexType _sex;                                                 // sex (gender)
-        int _nLifespan;                                               // lifespan in years
+        const PersonAttributes* _attributes;                          // owned by the community that read the population
+        const std::vector<Location*>* _locations;                     // the locations of this person's community
         bool _bDead;                                                  // is dead
         std::bitset<NUM_OF_SEROTYPES> _nImmunity;                     // bitmask of serotype infection
         bool _bVaccinated;                                            // has been vaccinated
         bool _bNaiveVaccineProtection; // if vaccinated, do we use the naive or non-naive VE_S?
 
-        std::vector<std::pair<int,double> > _swap_probabilities;      // list of the nearest people one year younger, with distances
         std::vector<Infection*> infectionHistory;
         std::vector<int> vaccineHistory;
         void clearInfectionHistory();
 
-        static const Parameters* _par;
-        static int _nNextID;                                          // unique ID to assign to the next Person allocated
+        Community* _community;                                        // the community this person belongs to
+        const Parameters* _par;                                       // the community's parameters
 };
 #endif
@@ -0,0 +1,137 @@
+// RandomStreams.cpp
+
+#include <cstdint>
+#include <assert.h>
+#include "RandomStreams.h"
+#include "Snapshot.h"
+
+namespace {
+    // generator state: the 64-bit key and 128-bit counter of the current block, and the block's output
+    struct PhiloxState {
+        uint32_t key[2];
+        uint32_t ctr[4];                                      // [0] and [1]: position in stream; [2]: substream; [3]: epoch
+        uint32_t out[4];
+        unsigned int next;                                    // index of the next unused value in out
+    };
+
+    const uint32_t PHILOX_M0 = 0xD2511F53;
+    const uint32_t PHILOX_M1 = 0xCD9E8D57;
+    const uint32_t PHILOX_W0 = 0x9E3779B9;                    // key schedule (Weyl sequence) increments
+    const uint32_t PHILOX_W1 = 0xBB67AE85;
+    const int PHILOX_ROUNDS = 10;
+
+    void philox4x32(const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4]) {
+        uint32_t x0 = ctr[0], x1 = ctr[1], x2 = ctr[2], x3 = ctr[3];
+        uint32_t k0 = key[0], k1 = key[1];
+        for (int round = 0; round < PHILOX_ROUNDS; ++round) {
+            const uint64_t p0 = (uint64_t) PHILOX_M0 * x0;
+            const uint64_t p1 = (uint64_t) PHILOX_M1 * x2;
+            const uint32_t y0 = (uint32_t) (p1 >> 32) ^ x1 ^ k0;
+            const uint32_t y2 = (uint32_t) (p0 >> 32) ^ x3 ^ k1;
+            x1 = (uint32_t) p1;
+            x3 = (uint32_t) p0;
+            x0 = y0;
+            x2 = y2;
+            k0 += PHILOX_W0;
+            k1 += PHILOX_W1;
+        }
+        out[0] = x0; out[1] = x1; out[2] = x2; out[3] = x3;
+    }
+
+    uint64_t mix64(uint64_t z) {                              // splitmix64 finalizer; spreads seeds over the key space
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    void start_stream(PhiloxState* s, uint64_t key, unsigned int substream, unsigned int epoch) {
+        s->key[0] = (uint32_t) key;
+        s->key[1] = (uint32_t) (key >> 32);
+        s->ctr[0] = s->ctr[1] = 0;
+        s->ctr[2] = substream;
+        s->ctr[3] = epoch;
+        s->next = 4;                                          // nothing generated yet
+    }
+
+    void philox_set(void* vstate, unsigned long int seed) {
+        start_stream((PhiloxState*) vstate, mix64(seed), 0, 0);
+    }
+
+    unsigned long int philox_get(void* vstate) {
+        PhiloxState* s = (PhiloxState*) vstate;
+        if (s->next == 4) {
+            philox4x32(s->ctr, s->key, s->out);
+            if (++s->ctr[0] == 0) ++s->ctr[1];
+            s->next = 0;
+        }
+        return s->out[s->next++];
+    }
+
+    double philox_get_double(void* vstate) {
+        return philox_get(vstate) / 4294967296.0;
+    }
+
+    const gsl_rng_type philox_type = { "philox4x32", 0xffffffffUL, 0, sizeof(PhiloxState), &philox_set, &philox_get, &philox_get_double };
+
+    // key for a purpose's streams; keys for different purposes (or seeds) are unrelated
+    uint64_t stream_key(unsigned long int seed, RandomPurpose purpose) {
+        return mix64(mix64(seed) + 0x9E3779B97F4A7C15ULL * ((uint64_t) purpose + 1));
+    }
+}
+
+const gsl_rng_type* rng_philox4x32 = &philox_type;
+
+
+RandomStreams::RandomStreams(unsigned long int seed, unsigned int substream) : _seed(seed), _substream(substream) {
+    for (int p = 0; p < NUM_OF_RANDOM_PURPOSES; ++p) _stream[p] = alloc(seed, (RandomPurpose) p, substream);
+}
+
+
+RandomStreams::~RandomStreams() {
+    for (int p = 0; p < NUM_OF_RANDOM_PURPOSES; ++p) gsl_rng_free(_stream[p]);
+}
+
+
+void RandomStreams::reseed(unsigned long int seed) {
+    _seed = seed;
+    for (int p = 0; p < NUM_OF_RANDOM_PURPOSES; ++p) set(_stream[p], seed, (RandomPurpose) p, _substream);
+}
+
+
+void RandomStreams::write(std::ostream& os) const {
+    snapshot::write(os, (uint64_t) _seed);
+    snapshot::write(os, _substream);
+    for (int p = 0; p < NUM_OF_RANDOM_PURPOSES; ++p) snapshot::write(os, *(const PhiloxState*) _stream[p]->state);
+}
+
+
+void RandomStreams::read(std::istream& is) {
+    uint64_t seed = 0;
+    snapshot::read(is, seed);
+    snapshot::read(is, _substream);
+    _seed = seed;
+    for (int p = 0; p < NUM_OF_RANDOM_PURPOSES; ++p) snapshot::read(is, *(PhiloxState*) _stream[p]->state);
+}
+
+
+gsl_rng* RandomStreams::alloc(unsigned long int seed, RandomPurpose purpose, unsigned int substream, unsigned int epoch) {
+    gsl_rng* r = gsl_rng_alloc(rng_philox4x32);
+    set(r, seed, purpose, substream, epoch);
+    return r;
+}
+
+
+void RandomStreams::set(const gsl_rng* r, unsigned long int seed, RandomPurpose purpose, unsigned int substream, unsigned int epoch) {
+    assert(r->type == rng_philox4x32);
+    start_stream((PhiloxState*) r->state, stream_key(seed, purpose), substream, epoch);
+}
+
+
+unsigned long int RandomStreams::runSeed(unsigned long int seed, unsigned int run) {
+    return run == 0 ? seed : mix64(mix64(seed) ^ mix64((uint64_t) run + 0x8CB92BA72F3D8DD7ULL));
+}
+
+
+unsigned long int RandomStreams::branchSeed(unsigned long int seed, unsigned int branch, unsigned int day) {
+    return mix64(mix64(seed) ^ mix64(((uint64_t) day << 32 | branch) + 0xD1B54A32D192ED03ULL));
+}
@@ -0,0 +1,62 @@
+// RandomStreams.h
+// Independent streams of random numbers for a simulation.  Numbers come from a counter-based generator
+// (Philox4x32-10; Salmon et al. 2011) that is wrapped as a GSL generator type, so a stream can be passed to
+// any gsl_rng_* or gsl_ran_* function.  A stream is identified by the simulation's seed, a purpose, and
+// optionally a substream (e.g., a location or a chunk of work) and an epoch (e.g., a day).  The n-th number
+// in a stream depends only on the stream's identity and n, so streams never overlap, and drawing more or
+// fewer numbers from one stream leaves every other stream unchanged.  Work that is split among threads
+// gives the same results with any number of threads if each piece draws from its own substream.
+#ifndef __RANDOMSTREAMS_H
+#define __RANDOMSTREAMS_H
+#include <iostream>
+#include <gsl/gsl_rng.h>
+
+enum RandomPurpose {
+    SETUP_RNG,                                              // building the community (e.g., mosquito capacities)
+    INTRODUCTION_RNG,                                       // who is exposed to introduced infections
+    HUMAN_INFECTION_RNG,                                    // the course of infections in people
+    BITING_RNG,                                             // who infectious mosquitoes bite, and mosquitoes infected by people
+    MOSQUITO_MOVEMENT_RNG,
+    MOSQUITO_SURVIVAL_RNG,                                  // seasonal decline in the number of mosquitoes
+    VECTOR_CONTROL_RNG,                                     // which locations are treated when, and mosquitoes killed
+    VACCINATION_RNG,                                        // who is vaccinated, and the protection they get
+    BIRTHDAY_RNG,                                           // immunity swaps on birthdays
+    NUM_OF_RANDOM_PURPOSES
+};
+
+// substream of SETUP_RNG for the serotypes introduced each year, if they are simulated (see
+// Parameters::generateAnnualSerotypes()); communities and their tiles use substreams from 0 up
+static const unsigned int SEROTYPE_RUN_SUBSTREAM = 0xFFFFFFFF;
+
+extern const gsl_rng_type* rng_philox4x32;                  // gsl_rng_set(r, seed) selects stream (seed, 0, 0)
+
+class RandomStreams {
+    public:
+        RandomStreams(unsigned long int seed, unsigned int substream = 0); // one stream per purpose, with epoch 0
+        ~RandomStreams();
+        const gsl_rng* get(RandomPurpose purpose) const { return _stream[purpose]; }
+        unsigned long int getSeed() const { return _seed; }
+        unsigned int getSubstream() const { return _substream; }
+        void reseed(unsigned long int seed);                          // moves each stream to the start of seed's stream
+        void write(std::ostream& os) const;                           // each stream's position, for a snapshot
+        void read(std::istream& is);                                  // continues from the positions written
+
+        static gsl_rng* alloc(unsigned long int seed, RandomPurpose purpose, unsigned int substream = 0, unsigned int epoch = 0);
+        // moves a generator allocated as rng_philox4x32 to the start of a stream; does not allocate
+        static void set(const gsl_rng* r, unsigned long int seed, RandomPurpose purpose, unsigned int substream = 0, unsigned int epoch = 0);
+        // the seed of one of several branches that continue a simulation with seed from the start of day; its
+        // streams are unrelated to those of seed and of other branches, whose substreams and epochs are in use
+        static unsigned long int branchSeed(unsigned long int seed, unsigned int branch, unsigned int day);
+        // the seed of the n-th of several runs that a simulation with seed makes in turn from the start (e.g., after
+        // Community::reset()); run 0's is seed itself, and the others' streams are unrelated to it and to each other
+        static unsigned long int runSeed(unsigned long int seed, unsigned int run);
+
+    private:
+        RandomStreams(const RandomStreams&) = delete;
+        RandomStreams& operator=(const RandomStreams&) = delete;
+
+        unsigned long int _seed;
+        unsigned int _substream;
+        gsl_rng* _stream[NUM_OF_RANDOM_PURPOSES];
+};
+#endif
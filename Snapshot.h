@@ -0,0 +1,83 @@
+// Snapshot.h
+// Reading and writing the binary snapshots of a simulation in progress (see Community::writeSnapshot() and
+// write_snapshot() in simulator.h).  Values and arrays of values are copied to and from the stream as they are
+// in memory, so a snapshot is only read back on the kind of machine (and by a build of the model) that wrote
+// it; the version must be incremented whenever anything that is written changes.  Readers check the stream's
+// state once a part of the snapshot has been read, rather than after each value.
+#ifndef __SNAPSHOT_H
+#define __SNAPSHOT_H
+#include <iostream>
+#include <string>
+#include <vector>
+#include <type_traits>
+#include <cstdint>
+
+namespace snapshot {
+    const char MAGIC[8] = {'D', 'E', 'N', 'G', 'S', 'N', 'A', 'P'};
+    const uint32_t VERSION = 1;
+    const uint64_t MAX_BYTES = 1ULL << 36;                            // larger arrays are taken to mean a corrupt snapshot
+
+    template <typename T>
+    inline void write(std::ostream& os, const T& x) {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain values are written as they are");
+        os.write(reinterpret_cast<const char*>(&x), sizeof(T));
+    }
+
+    template <typename T>
+    inline void read(std::istream& is, T& x) {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain values are read as they are");
+        is.read(reinterpret_cast<char*>(&x), sizeof(T));
+    }
+
+    template <typename T>
+    inline void write(std::ostream& os, const std::vector<T>& v) {
+        static_assert(std::is_trivially_copyable<T>::value, "only arrays of plain values are written as they are");
+        write(os, (uint64_t) v.size());
+        os.write(reinterpret_cast<const char*>(v.data()), v.size() * sizeof(T));
+    }
+
+    // T need not have a default constructor (e.g., MosquitoCohort)
+    template <typename T>
+    inline void read(std::istream& is, std::vector<T>& v) {
+        static_assert(std::is_trivially_copyable<T>::value, "only arrays of plain values are read as they are");
+        uint64_t n = 0;
+        read(is, n);
+        v.clear();
+        if (not is or n * sizeof(T) > MAX_BYTES) {
+            is.setstate(std::ios::failbit);
+            return;
+        }
+        std::vector<char> buffer(n * sizeof(T));
+        is.read(buffer.data(), buffer.size());
+        const T* first = reinterpret_cast<const T*>(buffer.data());
+        if (is) v.assign(first, first + n);
+    }
+
+    inline void write(std::ostream& os, const std::string& s) {
+        write(os, std::vector<char>(s.begin(), s.end()));
+    }
+
+    inline void read(std::istream& is, std::string& s) {
+        std::vector<char> chars;
+        read(is, chars);
+        s.assign(chars.begin(), chars.end());
+    }
+
+    inline void write(std::ostream& os, const std::vector<bool>& v) {
+        write(os, std::vector<char>(v.begin(), v.end()));
+    }
+
+    inline void read(std::istream& is, std::vector<bool>& v) {
+        std::vector<char> chars;
+        read(is, chars);
+        v.assign(chars.begin(), chars.end());
+    }
+
+    // 64-bit FNV-1a hash, e.g. of the description of a cached snapshot (see SnapshotCache in simulator.h);
+    // continue a hash by passing the previous result as h
+    inline uint64_t digest(const char* data, size_t n, uint64_t h = 14695981039346656037ULL) {
+        for (size_t i = 0; i < n; i++) h = (h ^ (unsigned char) data[i]) * 1099511628211ULL;
+        return h;
+    }
+}
+#endif
@@ -0,0 +1,130 @@
+// ThreadPool.cpp
+
+#include <assert.h>
+#include <iostream>
+#include "ThreadPool.h"
+
+using namespace std;
+
+ThreadPool::ThreadPool(unsigned int nthreads, int firstcore) : _blocks(nthreads), _task(nullptr), _nJob(0), _nBusyWorkers(0), _bStop(false), _nFirstCore(firstcore) {
+    assert(nthreads > 0);
+#ifdef __linux__
+    _caller = pthread_self();
+    _bCallerPinned = _nFirstCore >= 0 and pthread_getaffinity_np(_caller, sizeof(_callerCores), &_callerCores) == 0;
+#endif
+    _pin(0);
+    for (unsigned int t = 1; t < nthreads; ++t) _workers.emplace_back(&ThreadPool::_workerLoop, this, t);
+}
+
+
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard<mutex> lock(_mutex);
+        _bStop = true;
+    }
+    _jobReady.notify_all();
+    for (thread &w: _workers) w.join();
+#ifdef __linux__
+    if (_bCallerPinned) pthread_setaffinity_np(_caller, sizeof(_callerCores), &_callerCores);
+#endif
+}
+
+
+void ThreadPool::run(unsigned int ntasks, const function<void(unsigned int)>& task) {
+    if (_workers.size() == 0 or ntasks <= 1) {
+        for (unsigned int i = 0; i < ntasks; ++i) task(i);
+        return;
+    }
+    {
+        lock_guard<mutex> lock(_mutex);
+        for (unsigned int t = 0; t < size(); ++t) {                   // workers are idle, so blocks need no locking
+            _blocks[t].next = (unsigned long int) ntasks * t / size();
+            _blocks[t].end = (unsigned long int) ntasks * (t+1) / size();
+        }
+        _task = &task;
+        _nBusyWorkers = _workers.size();
+        ++_nJob;
+    }
+    _jobReady.notify_all();
+    _work(0);
+    unique_lock<mutex> lock(_mutex);
+    _jobDone.wait(lock, [this]{ return _nBusyWorkers == 0; });
+    _task = nullptr;
+}
+
+
+bool ThreadPool::_take(unsigned int thread, unsigned int &i) {
+    TaskBlock &block = _blocks[thread];
+    lock_guard<mutex> lock(block.mutex);
+    if (block.next == block.end) return false;
+    i = block.next++;
+    return true;
+}
+
+
+// Another thread may empty a block just after it is checked, or be holding stolen tasks not yet added to its
+// own block, so a failed steal does not mean that every task has started.  It does mean that every remaining
+// task is in some other thread's hands, and that thread will run it.
+bool ThreadPool::_steal(unsigned int thread) {
+    for (unsigned int k = 1; k < size(); ++k) {
+        TaskBlock &victim = _blocks[(thread + k) % size()];
+        unsigned int first, last;
+        {
+            lock_guard<mutex> lock(victim.mutex);
+            const unsigned int remaining = victim.end - victim.next;
+            if (remaining == 0) continue;
+            first = victim.end - (remaining + 1) / 2;                 // the victim keeps the tasks it would run next
+            last = victim.end;
+            victim.end = first;
+        }
+        TaskBlock &own = _blocks[thread];
+        lock_guard<mutex> lock(own.mutex);
+        own.next = first;
+        own.end = last;
+        return true;
+    }
+    return false;
+}
+
+
+void ThreadPool::_work(unsigned int thread) {
+    unsigned int i;
+    do {
+        while (_take(thread, i)) (*_task)(i);
+    } while (_steal(thread));
+}
+
+
+void ThreadPool::_pin(unsigned int thread) {
+    if (_nFirstCore < 0) return;
+#ifdef __linux__
+    const unsigned int core = _nFirstCore + thread;
+    cpu_set_t cores;
+    CPU_ZERO(&cores);
+    if (core < CPU_SETSIZE) CPU_SET(core, &cores);
+    if (core >= CPU_SETSIZE or pthread_setaffinity_np(pthread_self(), sizeof(cores), &cores) != 0) {
+        cerr << "WARNING: could not pin thread " << thread << " to core " << core << endl;
+    }
+#else
+    if (thread == 0) cerr << "WARNING: threads can only be pinned to cores on Linux" << endl;
+#endif
+}
+
+
+void ThreadPool::_workerLoop(unsigned int thread) {
+    _pin(thread);
+    unsigned long int lastJob = 0;
+    while (true) {
+        {
+            unique_lock<mutex> lock(_mutex);
+            _jobReady.wait(lock, [&]{ return _bStop or _nJob != lastJob; });
+            if (_bStop) return;
+            lastJob = _nJob;
+        }
+        _work(thread);
+        {
+            lock_guard<mutex> lock(_mutex);
+            if (--_nBusyWorkers == 0) _jobDone.notify_one();
+        }
+    }
+}
@@ -0,0 +1,62 @@
+// ThreadPool.h
+// A fixed set of worker threads that run numbered tasks.  run(n, task) calls task(i) for each i in [0, n),
+// spreading the calls across the workers and the calling thread, and returns once all calls have finished.
+// Tasks are scheduled by work stealing: each thread starts with a contiguous block of tasks, runs them in
+// order, and when it runs out takes the second half of the remaining block of another thread.  Many small
+// tasks therefore keep every thread busy even when a few tasks take much longer than the rest.
+// A pool of size 1 starts no threads and runs every task in the calling thread.  Threads may be pinned to
+// consecutive cores (Linux only), starting with the calling thread, which gets its own affinity back when
+// the pool is destroyed.
+#ifndef __THREADPOOL_H
+#define __THREADPOOL_H
+#include <vector>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+class ThreadPool {
+    public:
+        ThreadPool(unsigned int nthreads, int firstcore = -1);        // nthreads includes the calling thread; thread t
+                                                                      // is pinned to core firstcore+t, unless firstcore < 0
+        ~ThreadPool();
+        unsigned int size() const { return _workers.size() + 1; }
+        void run(unsigned int ntasks, const std::function<void(unsigned int)>& task);
+
+    private:
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+        struct TaskBlock {                                            // tasks [next, end) waiting to be run by one thread
+            TaskBlock() : next(0), end(0) {}
+            std::mutex mutex;
+            unsigned int next;
+            unsigned int end;
+        };
+        bool _take(unsigned int thread, unsigned int &i);             // next task from this thread's own block
+        bool _steal(unsigned int thread);                             // refills this thread's block from another's
+        void _work(unsigned int thread);                              // runs tasks until none are left to take or steal
+        void _workerLoop(unsigned int thread);
+        void _pin(unsigned int thread);                               // to core _nFirstCore+thread, if pinning
+
+        std::vector<std::thread> _workers;                            // threads 1..size()-1; the caller is thread 0
+        std::vector<TaskBlock> _blocks;                               // by thread
+        std::mutex _mutex;
+        std::condition_variable _jobReady;
+        std::condition_variable _jobDone;
+        const std::function<void(unsigned int)>* _task;               // the current job
+        unsigned long int _nJob;                                      // incremented for each job, so workers can tell
+                                                                      // a new job from a spurious wakeup
+        unsigned int _nBusyWorkers;
+        bool _bStop;
+        int _nFirstCore;
+#ifdef __linux__
+        pthread_t _caller;                                            // thread 0
+        cpu_set_t _callerCores;                                       // thread 0's affinity before it was pinned
+        bool _bCallerPinned;
+#endif
+};
+#endif
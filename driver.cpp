@@ -1,13 +1,129 @@
 #include "simulator.h"
 
+// With -replicates k, simulates k replicates together (see simulate_ensemble() in simulator.h), with seeds
+// randomseed, ..., randomseed+k-1.  Replicate r is the same as a run of its own with -randomseed randomseed+r and
+// output files named <name>.r, and the replicates' output lines are labeled with r.
+void simulate_replicates(const Parameters* par, int argc, char* argv[]) {
+    vector<const Parameters*> pars;
+    vector<Community*> communities;
+    for (int r = 0; r < par->nReplicates; r++) {
+        vector<string> args(argv, argv + argc);
+        args.insert(args.end(), {"-randomseed", to_string(par->randomseed + r), "-threads", "1", "-pinthreads", "-1"});
+        if (par->peopleOutputFilename.length() > 0) args.insert(args.end(), {"-peopleoutputfile", par->peopleOutputFilename + "." + to_string(r)});
+        if (par->yearlyPeopleOutputFilename.length() > 0) args.insert(args.end(), {"-yearlypeopleoutputfile", par->yearlyPeopleOutputFilename + "." + to_string(r)});
+        if (par->dailyOutputFilename.length() > 0) args.insert(args.end(), {"-dailyoutputfile", par->dailyOutputFilename + "." + to_string(r)});
+        vector<char*> replicate_argv;
+        for (string& a: args) replicate_argv.push_back(&a[0]);
+        replicate_argv.push_back(nullptr);
+
+        Parameters* replicate_par = new Parameters(args.size(), replicate_argv.data());
+        replicate_par->defineSerotypeRelativeRisks();
+        pars.push_back(replicate_par);
+        // the first replicate is read from the input files, and the rest share its static tables
+        communities.push_back(r == 0 ? build_community(replicate_par) : replicate_community(replicate_par, communities[0]));
+    }
+
+    vector< vector<int> > initial_susceptibles;
+    for (int r = 0; r < par->nReplicates; r++) {
+        initial_susceptibles.push_back(communities[r]->getNumSusceptible());
+        seed_epidemic(pars[r], communities[r]);
+    }
+    simulate_ensemble(pars, communities, par->nThreads, par->nFirstCore);
+    for (int r = 0; r < par->nReplicates; r++) write_output(pars[r], communities[r], initial_susceptibles[r]);
+
+    for (int r = par->nReplicates - 1; r >= 0; r--) {                // replicates before the community they share
+        delete communities[r];
+        delete pars[r];
+    }
+}
+
+
+// With -batch <file>, runs one simulation per line of the file, whose options are added to the rest of the
+// command line; output files are named with the job number appended (see job_parameters() in simulator.h).  The
+// community is built once, and restarted for each job that reads the same files.
+void simulate_batch(const vector<string>& args, const string batchFilename) {
+    vector<string> jobs;
+    if (!read_jobs(batchFilename, jobs)) exit(-1);
+    Parameters* par = nullptr;
+    Community* community = nullptr;
+    for (unsigned int n = 0; n < jobs.size(); n++) {
+        cerr << "job " << n << " of " << jobs.size() << ": " << jobs[n] << endl;
+        Parameters* jobpar = job_parameters(args, jobs[n], n);
+        simulate_job(jobpar, community, to_string(n));
+        delete par;                                                   // no longer used by the community
+        par = jobpar;
+    }
+    delete community;
+    delete par;
+}
+
+
+// With -batch <file> -branchday <day>, the jobs are scenarios that share a burn-in: the rest of the command line is
+// simulated once up to the start of day <day>, and each job continues from there (see simulate_branches() in
+// simulator.h, which says which options a job may change).  Output files are named as for -batch.
+void simulate_batch_branches(vector<string> args, const string batchFilename, const int branchDay) {
+    vector<string> jobs;
+    if (!read_jobs(batchFilename, jobs)) exit(-1);
+    vector<char*> argv;
+    for (string& a: args) argv.push_back(&a[0]);
+    argv.push_back(nullptr);
+    Parameters* par = new Parameters(args.size(), argv.data());
+    par->defineSerotypeRelativeRisks();
+
+    vector<const Parameters*> jobpars;
+    for (unsigned int n = 0; n < jobs.size(); n++) jobpars.push_back(job_parameters(args, jobs[n], n));
+    Community* community = build_community(par);
+    vector<int> initial_susceptibles = community->getNumSusceptible();
+    seed_epidemic(par, community);
+    simulate_branches(par, community, branchDay, jobpars,
+        [&](unsigned int n, Community* c) {
+            cerr << "finished job " << n << " of " << jobs.size() << ": " << jobs[n] << endl;
+            write_output(jobpars[n], c, initial_susceptibles);
+        });
+    delete community;
+    for (const Parameters* jobpar: jobpars) delete jobpar;
+    delete par;
+}
+
+
 int main(int argc, char* argv[]) {
-    const Parameters* par = new Parameters(argc, argv);
+    vector<string> args;
+    string batchFilename;
+    int branchDay = -1;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "-batch") == 0 and i + 1 < argc) {
+            batchFilename = argv[++i];
+        } else if (strcmp(argv[i], "-branchday") == 0 and i + 1 < argc) {
+            branchDay = strtol(argv[++i], nullptr, 10);
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
+    if (branchDay >= 0 and batchFilename.length() == 0) {
+        cerr << "ERROR: -branchday is only used with -batch" << endl;
+        return -1;
+    }
+    if (branchDay >= 0) {
+        simulate_batch_branches(args, batchFilename, branchDay);
+        return 0;
+    } else if (batchFilename.length() > 0) {
+        simulate_batch(args, batchFilename);
+        return 0;
+    }
+
+    Parameters* par = new Parameters(argc, argv);
+    par->defineSerotypeRelativeRisks();
+
+    if (par->nReplicates > 1) {
+        simulate_replicates(par, argc, argv);
+        return 0;
+    }
 
     Community* community = build_community(par);
     vector<int> initial_susceptibles = community->getNumSusceptible();
     seed_epidemic(par, community);
     simulate_epidemic(par, community);
     write_output(par, community, initial_susceptibles);
-    
+
     return 0;
 }
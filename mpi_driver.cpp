@@ -1,32 +1,87 @@
+#include "mpi.h"
 #include "simulator.h"
 #include <time.h>
+#include <unistd.h>
 
-int main(int argc, char* argv[]) {
-    time_t start ,end;
-    time (&start);
+// Two modes.  By default, each rank of MPI_COMM_WORLD runs its own simulation from the command line, as the
+// single-process model does, and writes its own output.
+//
+// With -taskfarm <file>, runs many independent simulations instead: each line of the file is one task, whose
+// options are appended to the rest of the command line, as for -batch in driver.cpp (see job_parameters() in
+// simulator.h; output files are named with the task number appended).  Rank 0 hands out
+// tasks one at a time to whichever worker rank asks next, and as each task comes back prints what it wrote to
+// stdout (e.g., its daily, weekly and yearly lines), then its line of results; each worker keeps the community it
+// built and restarts it for its next task if that reads the same files (see reuse_community() in simulator.h).
+// A task that fails stops the whole farm (see abort_failed_task()).
+//
+// In either mode each rank may run several threads (-threads), so that one rank per node or socket can use all
+// of its cores with one copy of the population.  Only a rank's main thread calls MPI.  With -pinthreads <core>,
+// the ranks on each node pin their threads to consecutive, non-overlapping ranges of cores starting there.
 
-    srand(time(NULL));
-    int proccess_id = rand();
-    fprintf(stderr, "%dbegin\n", proccess_id);
+enum TaskFarmTag { RESULT_TAG, TASK_TAG, STOP_TAG };
 
-    const Parameters* par = new Parameters(argc, argv);
+int nodeRank = 0;                                                     // this rank's position among the ranks on its node
+string runningTask;                                                   // the task this worker is running, if any
 
-    Community* community = build_community(par);
-    vector<int> initial_susceptibles = community->getNumSusceptible();
-    seed_epidemic(par, community);
-    vector<int> epi_sizes = simulate_epidemic(par, community);
 
-    const double ef = par->expansionFactor;
+// offsets the cores the threads are pinned to (if any), so that ranks on the same node use different cores
+void place_threads(Parameters* par) {
+    if (par->nFirstCore >= 0) par->nFirstCore += nodeRank * par->nThreads;
+}
+
+
+void send_string(const string& s, int dest, int tag) {
+    MPI_Send(s.c_str(), s.size(), MPI_CHAR, dest, tag, MPI_COMM_WORLD);
+}
+
+
+string receive_string(int source, int tag, MPI_Status* status) {
+    int length;
+    MPI_Probe(source, tag, MPI_COMM_WORLD, status);
+    MPI_Get_count(status, MPI_CHAR, &length);
+    vector<char> buffer(length);
+    MPI_Recv(buffer.data(), length, MPI_CHAR, status->MPI_SOURCE, status->MPI_TAG, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    return string(buffer.begin(), buffer.end());
+}
+
+
+// mean, stdev and max of yearly reported cases, and their linear trend
+string summarize(const vector<int>& epi_sizes) {
     vector<double> x(epi_sizes.size());
     vector<double> y(epi_sizes.size());
-    // convert infections to cases
-    for (unsigned int i = 0; i < epi_sizes.size(); i++) { 
-        y[i] = ((double) epi_sizes[i])/ef; 
+    // epi_sizes are already reported cases (see periodic_output())
+    for (unsigned int i = 0; i < epi_sizes.size(); i++) {
+        y[i] = epi_sizes[i];
         x[i] = i+1.0;
     }
 
     Fit* fit = lin_reg(x, y);
-    
+    stringstream ss;
+    ss << mean(y) << " " << stdev(y) << " " << max_element(y) << " "
+       << fit->m << " " << fit->b << " " << fit->rsq;
+    delete fit;
+    return ss.str();
+}
+
+
+// Runs this rank's own simulation
+void simulate(int argc, char* argv[], time_t start) {
+    time_t end;
+
+    srand(time(NULL));
+    int proccess_id = rand();
+    fprintf(stderr, "%dbegin\n", proccess_id);
+
+    Parameters* par = new Parameters(argc, argv);
+    par->defineSerotypeRelativeRisks();
+    place_threads(par);
+
+    Community* community = build_community(par);
+    vector<int> initial_susceptibles = community->getNumSusceptible();
+    seed_epidemic(par, community);
+    vector<int> epi_sizes = simulate_epidemic(par, community, to_string(proccess_id));
+
+    const string metrics = summarize(epi_sizes);
     time (&end);
     double dif = difftime (end,start);
 
@@ -34,22 +89,174 @@ int main(int argc, char* argv[]) {
     // wallclock time (seconds)
     ss << proccess_id << "end " << dif << " ";
     // parameters
-    ss << par->expansionFactor << " " << par->fMosquitoMove << " " << par->nDailyExposed[0][0] << " "
+    ss << par->fMosquitoMove << " " << par->nDailyExposed[0][0] << " "
        << par->betaMP << " " << par->betaPM << " ";
     // metrics
-    ss << mean(y) << " " << stdev(y) << " " << max_element(y) << " "
-       << fit->m << " " << fit->b << " " << fit->rsq;
+    ss << metrics;
 
     ss << endl;
     string output = ss.str();
     fputs(output.c_str(), stderr);
-    
-    // metrics to stdout
-    cout << mean(y) << " " << stdev(y) << " " << max_element(y) << " "
-       << fit->m << " " << fit->b << " " << fit->rsq;
 
+    // metrics to stdout
+    cout << metrics;
 
     write_output(par, community, initial_susceptibles);
-   
+
+    delete community;
+    delete par;
+}
+
+
+// Runs one task ("<task number> <options>"), reusing community if possible; par holds the parameters that
+// community was last run with, and is replaced by the task's.  Returns the line of results for the task.
+string run_task(const string& task, const vector<string>& baseargs, Parameters*& par, Community*& community) {
+    time_t start, end;
+    time (&start);
+
+    const size_t split = task.find(' ');
+    const int taskid = stoi(task.substr(0, split));
+    Parameters* taskpar = job_parameters(baseargs, task.substr(split + 1), taskid);
+    place_threads(taskpar);
+    vector<int> epi_sizes = simulate_job(taskpar, community, to_string(taskid));
+    delete par;                                                       // no longer used by the community
+    par = taskpar;
+
+    time (&end);
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    stringstream ss;
+    // task, worker, wallclock time (seconds), metrics
+    ss << taskid << " " << rank << " " << difftime(end, start) << " " << summarize(epi_sizes) << endl;
+    return ss.str();
+}
+
+
+// Registered with atexit() on the workers.  A task that fails exits (e.g., on a missing input file), and would
+// otherwise leave rank 0 waiting for its results for ever, so the whole farm is stopped.
+void abort_failed_task() {
+    if (runningTask.empty()) return;
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    cerr << "ERROR: task " << runningTask.substr(0, runningTask.find(' ')) << " failed on rank " << rank << "; stopping all tasks" << endl;
+    MPI_Abort(MPI_COMM_WORLD, -1);
+}
+
+
+// Runs run_task(), and returns what the task wrote to stdout (including through cout), followed by its results.
+// The output is kept in a temporary file rather than in memory, since a long run's daily lines may be large.
+string run_task_with_output(const string& task, const vector<string>& baseargs, Parameters*& par, Community*& community) {
+    runningTask = task;
+    FILE* capture = tmpfile();
+    if (capture == NULL) {
+        cerr << "WARNING: cannot capture the output of task " << task << "; it will be lost" << endl;
+        const string result = run_task(task, baseargs, par, community);
+        runningTask.clear();
+        return result;
+    }
+    fflush(stdout);
+    const int saved = dup(fileno(stdout));
+    dup2(fileno(capture), fileno(stdout));
+    const string result = run_task(task, baseargs, par, community);
+    fflush(stdout);
+    dup2(saved, fileno(stdout));
+    close(saved);
+    runningTask.clear();
+
+    string output;
+    rewind(capture);
+    char buffer[65536];
+    for (size_t n; (n = fread(buffer, 1, sizeof(buffer), capture)) > 0; ) output.append(buffer, n);
+    fclose(capture);
+    return output + result;
+}
+
+
+void farm_tasks(const vector<string>& baseargs, const string& taskFilename) {
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    Parameters* par = nullptr;
+    Community* community = nullptr;
+    MPI_Status status;
+
+    if (rank == 0) {
+        vector<string> tasks;
+        if (!read_jobs(taskFilename, tasks)) MPI_Abort(MPI_COMM_WORLD, -1);
+        for (unsigned int i = 0; i < tasks.size(); i++) tasks[i] = to_string(i) + " " + tasks[i];
+        fprintf(stderr, "%d tasks for %d workers\n", (int) tasks.size(), size == 1 ? 1 : size - 1);
+
+        if (size == 1) {                                              // no workers, so the master does the work
+            for (const string& task: tasks) fputs(run_task(task, baseargs, par, community).c_str(), stdout);
+        } else {
+            unsigned int next = 0;
+            int working = size - 1;
+            while (working > 0) {
+                const string result = receive_string(MPI_ANY_SOURCE, RESULT_TAG, &status);
+                fputs(result.c_str(), stdout);                        // the task's output, then its results; empty
+                                                                      // if the worker is asking for its first task
+                fflush(stdout);
+                if (next < tasks.size()) {
+                    send_string(tasks[next++], status.MPI_SOURCE, TASK_TAG);
+                } else {
+                    send_string("", status.MPI_SOURCE, STOP_TAG);
+                    --working;
+                }
+            }
+        }
+    } else {
+        atexit(abort_failed_task);
+        string result;
+        while (true) {
+            send_string(result, 0, RESULT_TAG);
+            const string task = receive_string(0, MPI_ANY_TAG, &status);
+            if (status.MPI_TAG == STOP_TAG) break;
+            result = run_task_with_output(task, baseargs, par, community);
+        }
+    }
+
+    delete community;
+    delete par;
+}
+
+
+int main(int argc, char* argv[]) {
+    time_t start;
+    time (&start);
+
+    int threading;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &threading);
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    if (threading < MPI_THREAD_FUNNELED and rank == 0) {
+        cerr << "WARNING: this MPI library does not support threads; use -threads 1" << endl;
+    }
+    MPI_Comm node;
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node);
+    MPI_Comm_rank(node, &nodeRank);
+    MPI_Comm_free(&node);
+
+    vector<string> baseargs;
+    vector<char*> simargs;                                            // the command line, less mpi_driver's own options
+    string taskFilename;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "-taskfarm") == 0 and i + 1 < argc) {
+            taskFilename = argv[++i];
+        } else {
+            baseargs.push_back(argv[i]);
+            simargs.push_back(argv[i]);
+        }
+    }
+    if (rank > 0 and not taskFilename.empty()) {                     // rank 0 reports for all; workers send it their tasks' output
+        if (freopen("/dev/null", "w", stdout) == NULL) { cerr << "ERROR: cannot redirect output of rank " << rank << endl; }
+    }
+
+    if (taskFilename.empty()) {
+        simulate(simargs.size(), simargs.data(), start);
+    } else {
+        farm_tasks(baseargs, taskFilename);
+    }
+
+    MPI_Finalize();
     return 0;
 }
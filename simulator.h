@@ -5,6 +5,7 @@
 #include <fstream>
 #include <string>
 #include <sstream>
+#include <functional>
 #include <assert.h>
 #include <gsl/gsl_rng.h>
 #include <gsl/gsl_randist.h>
@@ -14,7 +15,11 @@
 #include "Location.h"
 #include "Community.h"
 #include "Utility.h"
+#include "Snapshot.h"
 #include "sys/stat.h"
+#include <dirent.h>
+#include <unistd.h>
+#include <utime.h>
 
 using namespace dengue::standard;
 using namespace dengue::util;
@@ -41,8 +46,8 @@ enum PrevalenceReportingType {
 
 class Date {
   public:
-    Date():_offset(0),_simulation_day(0) {};
-    Date(const Parameters* par):_offset(par->startDayOfYear-1),_simulation_day(0) {};
+    Date():_offset(0),_simulation_day(0),_month_ct(0) {};
+    Date(const Parameters* par):_offset(par->startDayOfYear-1),_simulation_day(0),_month_ct(0) {};
 
     int offset()             const { return _offset; }
     inline int day()         const { return _simulation_day; }                // [0, ...]
@@ -82,6 +87,11 @@ class Date {
         _simulation_day++;
     }
 
+    void restore(int simulation_day, int month_ct) {                // continue from a snapshot
+        _simulation_day = simulation_day;
+        _month_ct = month_ct;
+    }
+
     void print() {
         cerr << day() << "\t" << julianDay() << "\t" << year()
              << "\t(" << monthName() << " " << dayOfMonth() << ")\t" << month() << "\t" << julianMonth();
@@ -99,20 +109,27 @@ class Date {
     int _month_ct;
 };
 
+// Process-wide generator for drivers in exp/ that draw outside any simulation (e.g., sampling parameters); they
+// seed it themselves.  Simulations and their Parameters draw only from their own streams (Community::getRNG() and
+// Parameters::generateAnnualSerotypes()), so several can be set up and run at once.
 const gsl_rng* RNG = gsl_rng_alloc (gsl_rng_taus2);
 
 // Predeclare local functions
 Community* build_community(const Parameters* par);
+Community* reuse_community(const Parameters* par, Community* community);
+Community* replicate_community(const Parameters* par, const Community* structure);
 void seed_epidemic(const Parameters* par, Community* community);
 vector<int> simulate_epidemic(const Parameters* par, Community* community, const string process_id = "0");
 void write_immunity_file(const Community* community, const string label, string filename, int runLength);
 void write_immunity_by_age_file(const Community* community, const int year, string filename="");
 void write_output(const Parameters* par, Community* community, vector<int> initial_susceptibles);
+bool read_jobs(const string filename, vector<string>& jobs);
+Parameters* job_parameters(const vector<string>& args, const string job, const int n);
+vector<int> simulate_job(const Parameters* par, Community*& community, const string process_id);
 void write_daily_buffer( vector<string>& buffer, const string process_id, string filename);
 
 Community* build_community(const Parameters* par) {
     Community* community = new Community(par);
-    Person::setPar(par);
 
     if (!community->loadLocations(par->locationFilename, par->networkFilename)) {
         cerr << "ERROR: Could not load locations" << endl;
@@ -135,6 +152,36 @@ Community* build_community(const Parameters* par) {
 }
 
 
+// Returns a community as built by build_community(par): community itself, restarted, if it was built from the same
+// files (see Community::canRestart()), or else a new one, in which case community (if any) is deleted.  The
+// parameters community was built or last restarted with must still exist.
+Community* reuse_community(const Parameters* par, Community* community) {
+    if (not community or not community->canRestart(par)) {
+        delete community;
+        return build_community(par);
+    }
+    if (!community->restart(par)) {
+        cerr << "ERROR: Could not restart community" << endl;
+        exit(-1);
+    }
+    if (!par->bSecondaryTransmission) {
+        community->setNoSecondaryTransmission();
+    }
+    return community;
+}
+
+
+// Returns a replicate of structure (see Community.h) as build_community(par) would build it, if par named the same
+// files as the parameters structure was built with.
+Community* replicate_community(const Parameters* par, const Community* structure) {
+    Community* community = new Community(structure, par);
+    if (!par->bSecondaryTransmission) {
+        community->setNoSecondaryTransmission();
+    }
+    return community;
+}
+
+
 void seed_epidemic(const Parameters* par, Community* community) {
     // epidemic may be seeded with initial exposure OR initial infection
     bool attempt_initial_infection = true;
@@ -143,7 +190,7 @@ void seed_epidemic(const Parameters* par, Community* community) {
         if (par->nInitialExposed[serotype] > 0) {
             attempt_initial_infection = false;
             for (int i=0; i<par->nInitialExposed[serotype]; i++)
-                community->infect(gsl_rng_uniform_int(RNG, community->getNumPeople()), (Serotype) serotype,0);
+                community->infect(gsl_rng_uniform_int(community->getRNG(INTRODUCTION_RNG), community->getNumPeople()), (Serotype) serotype,0);
         }
     }
     if (attempt_initial_infection) {
@@ -154,7 +201,7 @@ void seed_epidemic(const Parameters* par, Community* community) {
 
                 // must infect nInitialInfected persons -- this bit is mysterious
                 while (community->getNumInfected(0) < count + par->nInitialInfected[serotype]) {
-                    community->infect(gsl_rng_uniform_int(RNG, community->getNumPeople()), (Serotype) serotype,0);
+                    community->infect(gsl_rng_uniform_int(community->getRNG(INTRODUCTION_RNG), community->getNumPeople()), (Serotype) serotype,0);
                 }
             }
         }
@@ -174,32 +221,40 @@ void write_yearly_people_file(const Parameters* par, const Community* community,
         exit(-1);
     }
     yearlyPeopleOutputFile << "pid,serotype,infectiontime,symptomtime,withdrawtime,recoverytime,immdenv1,immdenv2,immdenv3,immdenv4" << endl;
-    for (Person* p: community->getPeople()) {
-        for (int j=p->getNumNaturalInfections()-1; j>=0; j--) {
-            yearlyPeopleOutputFile << p->getID() << ","
-                << 1 + (int) p->getSerotype(j) << ","
-                << p->getInfectedTime(j) << ","
-                << p->getSymptomTime(j) << ","
-                << p->getWithdrawnTime(j) << ","
-                << p->getRecoveryTime(j) << ",";
-            for (int s = 0; s < NUM_OF_SEROTYPES - 1; ++s) {
-                yearlyPeopleOutputFile << (p->isSusceptible((Serotype) s)?0:1) << ",";
+    // blocks of people are formatted in parallel, then written in order
+    yearlyPeopleOutputFile << community->reducePeople(string(),
+        [](string& lines, const Person* p) {
+            ostringstream ss;
+            for (int j=p->getNumNaturalInfections()-1; j>=0; j--) {
+                ss << p->getID() << ","
+                    << 1 + (int) p->getSerotype(j) << ","
+                    << p->getInfectedTime(j) << ","
+                    << p->getSymptomTime(j) << ","
+                    << p->getWithdrawnTime(j) << ","
+                    << p->getRecoveryTime(j) << ",";
+                for (int s = 0; s < NUM_OF_SEROTYPES - 1; ++s) {
+                    ss << (p->isSusceptible((Serotype) s)?0:1) << ",";
+                }
+                    ss << (p->isSusceptible((Serotype) (NUM_OF_SEROTYPES - 1))?0:1) << endl;
             }
-                yearlyPeopleOutputFile << (p->isSusceptible((Serotype) (NUM_OF_SEROTYPES - 1))?0:1) << endl;
-        }
-    }
+            lines += ss.str();
+        },
+        [](string& lines, const string& block) { lines += block; });
     yearlyPeopleOutputFile.close();
     return;
 }
 
-void initialize_seasonality(const Parameters* par, Community* community, int& nextMosquitoMultiplierIndex, int& nextEIPindex, Date& date) {
+// Sets the mosquito multiplier and EIP to par's for the seasonal periods that include day (counted from the start of
+// par's seasonal cycles, which begin on the first day of the year), and the next indices to the periods after them
+void set_seasonality(const Parameters* par, Community* community, int& nextMosquitoMultiplierIndex, int& nextEIPindex, const int day) {
     const int mosquitoMultiplierTotalDuration = par->getMosquitoMultiplierTotalDuration();
     int currentDayOfYearOffset = 0;
     if (mosquitoMultiplierTotalDuration > 0) {
+        const int dayOfCycle = day % mosquitoMultiplierTotalDuration;
         nextMosquitoMultiplierIndex = 0;
-        while (currentDayOfYearOffset <= date.offset()) {
+        while (currentDayOfYearOffset <= dayOfCycle) {
             currentDayOfYearOffset += par->mosquitoMultipliers[nextMosquitoMultiplierIndex].duration;
-            if (currentDayOfYearOffset > date.offset()) {
+            if (currentDayOfYearOffset > dayOfCycle) {
                 const double mm = par->mosquitoMultipliers[nextMosquitoMultiplierIndex].value;
                 community->setMosquitoMultiplier(mm);
             }
@@ -210,10 +265,11 @@ void initialize_seasonality(const Parameters* par, Community* community, int& ne
     const int EIPtotalDuration = par->getEIPtotalDuration();
     currentDayOfYearOffset = 0;
     if (EIPtotalDuration > 0) {
+        const int dayOfCycle = day % EIPtotalDuration;
         nextEIPindex = 0;
-        while (currentDayOfYearOffset <= date.offset()) {
+        while (currentDayOfYearOffset <= dayOfCycle) {
             currentDayOfYearOffset += par->extrinsicIncubationPeriods[nextEIPindex].duration;
-            if (currentDayOfYearOffset > date.offset()) {
+            if (currentDayOfYearOffset > dayOfCycle) {
                 const double eip = par->extrinsicIncubationPeriods[nextEIPindex].value;
                 community->setExpectedExtrinsicIncubation(eip);
             }
@@ -223,6 +279,11 @@ void initialize_seasonality(const Parameters* par, Community* community, int& ne
 }
 
 
+void initialize_seasonality(const Parameters* par, Community* community, int& nextMosquitoMultiplierIndex, int& nextEIPindex, Date& date) {
+    set_seasonality(par, community, nextMosquitoMultiplierIndex, nextEIPindex, date.offset());
+}
+
+
 void _aggregator(map<string, vector<int> >& periodic_incidence, string key) {
     for (unsigned int i = 0; i < periodic_incidence["daily"].size(); ++i) periodic_incidence[key][i] += periodic_incidence["daily"][i];
 }
@@ -236,7 +297,8 @@ void _reporter(stringstream& ss, map<string, vector<int> > &periodic_incidence,
 }
 
 
-void periodic_output(const Parameters* par, const Community* community, map<string, vector<int> > &periodic_incidence, vector<int> &periodic_prevalence, const Date& date, const string process_id, vector<int>& epi_sizes) {
+// Writes the day's output lines to stdout, or appends them to *output if it is given
+void periodic_output(const Parameters* par, const Community* community, map<string, vector<int> > &periodic_incidence, vector<int> &periodic_prevalence, const Date& date, const string process_id, vector<int>& epi_sizes, string* output = nullptr) {
     stringstream ss;
 //if (date.day() >= 25*365 and date.day() < 36*365) {
 //if (date.day() >= 116*365) {                         // daily output starting in 1995, assuming Jan 1, 1879 simulation start
@@ -283,8 +345,14 @@ void periodic_output(const Parameters* par, const Community* community, map<stri
     _aggregator(periodic_incidence, "yearly");
     if (date.endOfYear()) {
         if (par->abcVerbose) {
-            cout << process_id << dec << " " << par->serial << " T: " << date.day() << " annual: ";
-            for (auto v: periodic_incidence["yearly"]) { cout << v << " "; } cout << endl;
+            stringstream annual;                     // not cout, which may be shared by communities in other threads
+            annual << process_id << dec << " " << par->serial << " T: " << date.day() << " annual: ";
+            for (auto v: periodic_incidence["yearly"]) { annual << v << " "; } annual << endl;
+            if (output) {
+                *output += annual.str();
+            } else {
+                fputs(annual.str().c_str(), stdout);
+            }
         }
 
         epi_sizes.push_back(periodic_incidence["yearly"][2]);
@@ -295,9 +363,12 @@ void periodic_output(const Parameters* par, const Community* community, map<stri
     }
 
     periodic_incidence["daily"] = vector<int>(NUM_OF_INCIDENCE_REPORTING_TYPES, 0);
-    string output = ss.str();
-    //fputs(output.c_str(), stderr);
-    fputs(output.c_str(), stdout);
+    if (output) {
+        *output += ss.str();
+    } else {
+        //fputs(ss.str().c_str(), stderr);
+        fputs(ss.str().c_str(), stdout);
+    }
 }
 
 void update_vaccinations(const Parameters* par, Community* community, const Date &date) {
@@ -313,17 +384,25 @@ void update_vaccinations(const Parameters* par, Community* community, const Date
     }
 }
 
-void schedule_vector_control(const Parameters* par, Community* community) {
+// Only campaigns that start in [fromDay, toDay) are scheduled (simulate_day() schedules each on the day it starts).
+// Each campaign draws from its own stream, given by its start day and its place among the campaigns that start
+// that day (epoch 0 of VECTOR_CONTROL_RNG is left to the tiles), so which locations it treats when does not depend
+// on when it is scheduled or on other campaigns.
+void schedule_vector_control(const Parameters* par, Community* community, int fromDay = 0, int toDay = INT_MAX) {
+    map<int, unsigned int> nStarting;                                 // campaigns that start on a day, so far
     for (VectorControlEvent vce: par->vectorControlEvents) {
+        const unsigned int substream = nStarting[vce.campaignStart]++;
+        if (vce.campaignStart < fromDay or vce.campaignStart >= toDay) continue;
+        gsl_rng* rng = RandomStreams::alloc(community->getSeed(), VECTOR_CONTROL_RNG, substream, vce.campaignStart + 1);
         const string loc_label = vce.locationType == 0 ? "houses" : vce.locationType == 1 ? "workplaces" : vce.locationType == 2 ? "schools" : "unknown location type";
         if (not par->abcVerbose) cerr << "will start treating " << vce.coverage*100 << "% of " << loc_label << " on day " << vce.campaignStart << endl;
 
         double rho = par->calculate_daily_vector_control_mortality(vce.efficacy);
         if (vce.strategy == UNIFORM_STRATEGY) {
             for (Location* loc: community->getLocations() ) {
-                if (loc->getType() == vce.locationType and  gsl_rng_uniform(RNG) < vce.coverage) {
+                if (loc->getType() == vce.locationType and  gsl_rng_uniform(rng) < vce.coverage) {
                    // location will be treated
-                   const int loc_treatment_date = vce.campaignStart + gsl_rng_uniform_int(RNG, vce.campaignDuration);
+                   const int loc_treatment_date = vce.campaignStart + gsl_rng_uniform_int(rng, vce.campaignDuration);
                    loc->scheduleVectorControlEvent(vce.efficacy, rho, loc_treatment_date, vce.efficacyDuration);
                 }
             }
@@ -331,7 +410,7 @@ void schedule_vector_control(const Parameters* par, Community* community) {
             for (Location* loc: community->getLocations() ) {
                 if (loc->getType() == vce.locationType and loc->getTrialArm() == 2) {
                    // location will be treated
-                   const int loc_treatment_date = vce.campaignStart + gsl_rng_uniform_int(RNG, vce.campaignDuration);
+                   const int loc_treatment_date = vce.campaignStart + gsl_rng_uniform_int(rng, vce.campaignDuration);
                    loc->scheduleVectorControlEvent(vce.efficacy, rho, loc_treatment_date, vce.efficacyDuration);
                 }
             }
@@ -342,6 +421,7 @@ void schedule_vector_control(const Parameters* par, Community* community) {
             cerr << "ERROR: Unsupported vector control strategy\n";
             exit(-832);
         }
+        gsl_rng_free(rng);
     }
 }
 
@@ -358,10 +438,10 @@ int seed_epidemic(const Parameters* par, Community* community, const Date &date)
         const double expected_num_exposed = serotype_weight * annual_intros_weight * intros;
         if (expected_num_exposed <= 0) continue;
         assert(expected_num_exposed <= numperson);
-        const int num_exposed = gsl_ran_poisson(RNG, expected_num_exposed);
+        const int num_exposed = gsl_ran_poisson(community->getRNG(INTRODUCTION_RNG), expected_num_exposed);
         for (int i=0; i<num_exposed; i++) {
             // gsl_rng_uniform_int returns on [0, numperson-1]
-            int transmit_to_id = gsl_rng_uniform_int(RNG, numperson);
+            int transmit_to_id = gsl_rng_uniform_int(community->getRNG(INTRODUCTION_RNG), numperson);
             if (community->infect(transmit_to_id, (Serotype) serotype, date.day())) {
                 introduced_infection_ct++;
             }
@@ -399,14 +479,14 @@ void update_extrinsic_incubation_period(const Parameters* par, Community* commun
 }
 
 
-void advance_simulator(const Parameters* par, Community* community, Date &date, const string process_id, map<string, vector<int> > &periodic_incidence, vector<int> &periodic_prevalence, int &nextMosquitoMultiplierIndex, int &nextEIPindex, vector<int> &epi_sizes) {
+void advance_simulator(const Parameters* par, Community* community, Date &date, const string process_id, map<string, vector<int> > &periodic_incidence, vector<int> &periodic_prevalence, int &nextMosquitoMultiplierIndex, int &nextEIPindex, vector<int> &epi_sizes, string* output = nullptr) {
     update_mosquito_population(par, community, date, nextMosquitoMultiplierIndex);
     update_extrinsic_incubation_period(par, community, date, nextEIPindex);
     community->tick(date.day());
 
     seed_epidemic(par, community, date);
 
-    for (Person* p: community->getPeople()) {
+    for (Person* p: community->getActiveInfections()) {
         if (p->isInfected(date.day())) {
             const Infection* infec = p->getInfection();
             bool intro  = not infec->isLocallyAcquired();
@@ -456,7 +536,7 @@ void advance_simulator(const Parameters* par, Community* community, Date &date,
         }
     }
 
-    periodic_output(par, community, periodic_incidence, periodic_prevalence, date, process_id, epi_sizes);
+    periodic_output(par, community, periodic_incidence, periodic_prevalence, date, process_id, epi_sizes, output);
     return;
 }
 
@@ -475,37 +555,329 @@ map<string, vector<int> > construct_tally() {
 }
 
 
-vector<int> simulate_epidemic_with_seroprev(const Parameters* par, Community* community, const string process_id, bool capture_sero_prev, vector< vector<double> > &sero_prev, int sero_prev_aggregation_julian_start=0) {
-    sero_prev = vector< vector<double> > (5, vector<double>(par->nRunLength/365, 0.0)); // rows are infection history: 0, 1, and 2+ infections
+// The state a simulation carries from day to day, besides its community's
+struct SimulationState {
+    SimulationState(const Parameters* par) :
+        date(par), nextMosquitoMultiplierIndex(0), nextEIPindex(0),
+        periodic_incidence(construct_tally()), periodic_prevalence(NUM_OF_PREVALENCE_REPORTING_TYPES, 0) {}
+    Date date;
+    int nextMosquitoMultiplierIndex;
+    int nextEIPindex;
+    map<string, vector<int> > periodic_incidence;
+    vector<int> periodic_prevalence;
     vector<int> epi_sizes;
-    Date date(par);
-    int nextMosquitoMultiplierIndex = 0;
-    int nextEIPindex = 0;
+};
 
-    initialize_seasonality(par, community, nextMosquitoMultiplierIndex, nextEIPindex, date);
-    schedule_vector_control(par, community);
+
+// A snapshot of a simulation at the start of a day (see Snapshot.h): the community, then the simulation's state.
+// It is read back into a community built from the same files, with the same tiles, and simulated with the same
+// parameters; the output after that day is then the same as if the simulation had not been interrupted.
+bool write_snapshot(ostream& os, const Community* community, const SimulationState& state) {
+    os.write(snapshot::MAGIC, sizeof(snapshot::MAGIC));
+    snapshot::write(os, snapshot::VERSION);
+    if (not community->writeSnapshot(os)) return false;
+    snapshot::write(os, state.date.offset());
+    snapshot::write(os, state.date.day());
+    snapshot::write(os, state.date.month());
+    snapshot::write(os, state.nextMosquitoMultiplierIndex);
+    snapshot::write(os, state.nextEIPindex);
+    snapshot::write(os, (uint32_t) state.periodic_incidence.size());
+    for (const auto &tally: state.periodic_incidence) {
+        snapshot::write(os, tally.first);
+        snapshot::write(os, tally.second);
+    }
+    snapshot::write(os, state.periodic_prevalence);
+    snapshot::write(os, state.epi_sizes);
+    return (bool) os;
+}
+
+
+bool read_snapshot(istream& is, Community* community, SimulationState& state) {
+    char magic[sizeof(snapshot::MAGIC)];
+    uint32_t version = 0;
+    is.read(magic, sizeof(magic));
+    snapshot::read(is, version);
+    if (not is or memcmp(magic, snapshot::MAGIC, sizeof(magic)) != 0) {
+        cerr << "ERROR: not a snapshot" << endl;
+        return false;
+    } else if (version != snapshot::VERSION) {
+        cerr << "ERROR: snapshot is version " << version << ", but this model reads version " << snapshot::VERSION << endl;
+        return false;
+    }
+    if (not community->readSnapshot(is)) return false;
+
+    int offset = 0, day = 0, month = 0;
+    snapshot::read(is, offset);
+    snapshot::read(is, day);
+    snapshot::read(is, month);
+    if (is and offset != state.date.offset()) {
+        cerr << "ERROR: snapshot was taken of a simulation that started on day " << offset + 1
+             << " of the year, but this one starts on day " << state.date.offset() + 1 << endl;
+        return false;
+    }
+    state.date.restore(day, month);
+    snapshot::read(is, state.nextMosquitoMultiplierIndex);
+    snapshot::read(is, state.nextEIPindex);
+    uint32_t n = 0;
+    snapshot::read(is, n);
+    state.periodic_incidence.clear();
+    for (uint32_t i = 0; i < n and is; i++) {
+        string key;
+        snapshot::read(is, key);
+        snapshot::read(is, state.periodic_incidence[key]);
+    }
+    snapshot::read(is, state.periodic_prevalence);
+    snapshot::read(is, state.epi_sizes);
+    if (not is) {
+        cerr << "ERROR: snapshot is truncated or corrupt" << endl;
+        return false;
+    }
+    return true;
+}
+
+
+bool write_snapshot(const string filename, const Community* community, const SimulationState& state) {
+    ofstream ofs(filename.c_str(), ios::binary);
+    if (!ofs) {
+        cerr << "ERROR: could not open " << filename << " for writing." << endl;
+        return false;
+    }
+    return write_snapshot(ofs, community, state);
+}
+
+
+bool read_snapshot(const string filename, Community* community, SimulationState& state) {
+    ifstream ifs(filename.c_str(), ios::binary);
+    if (!ifs) {
+        cerr << "ERROR: " << filename << " not found." << endl;
+        return false;
+    }
+    return read_snapshot(ifs, community, state);
+}
+
+
+// A directory of snapshots shared by simulations, e.g. the runs of a parameter sweep that share a burn-in
+// (-snapshotcache).  Snapshots are taken at the start of par->snapshotCacheDays, and a simulation resumes from the
+// latest of those days that is cached.  A snapshot is found by a digest of its description: par->snapshotCacheKey,
+// the contents of the input files, the vector control campaigns and vaccinations that start before its day, and
+// the day.  The state at the start of a day does not depend on campaigns or vaccinations that start later (see
+// schedule_vector_control()) or on the run length, so simulations that differ only in those share the snapshots
+// of the days before.  The file starts with the whole description, so a snapshot whose digest merely collides is
+// not used.  Once the cache holds more than par->snapshotCacheMegabytes, the snapshots used least recently (by
+// modification time, which is updated when one is used) are removed.  A simulation whose output covers the days
+// before a cached one (e.g., -dailyoutput) stores snapshots, but does not resume from them.
+class SnapshotCache {
+  public:
+    SnapshotCache(const Parameters* par) : _par(par), _days(par->snapshotCacheDays) {
+        if (par->snapshotCacheDirectory.length() == 0) return;
+        if (par->snapshotCacheKey.length() == 0) {
+            cerr << "ERROR: the snapshot cache needs a description of the parameters (Parameters::snapshotCacheKey)" << endl;
+            exit(-844);
+        }
+        _description = "snapshot version " + to_string(snapshot::VERSION) + "; options: " + par->snapshotCacheKey + "; files:";
+        for (const string& filename: { par->populationFilename, par->immunityFilename, par->locationFilename, par->networkFilename,
+                                       par->swapProbFilename, par->annualIntroductionsFilename, par->annualSerotypeFilename,
+                                       par->dailyEIPfilename, par->mosquitoFilename, par->mosquitoLocationFilename }) {
+            _description += " " + _hex(_fileDigest(filename));
+        }
+        mkdir(par->snapshotCacheDirectory.c_str(), 0777);             // if it does not exist
+        if (par->dailyOutput or par->periodicOutput or par->weeklyOutput or par->monthlyOutput or par->yearlyOutput
+            or par->studyOutput or par->abcVerbose or par->yearlyPeopleOutputFilename.length() > 0) {
+            keepEveryDay("periodic output");
+        }
+    }
+
+    bool enabled() const { return _description.length() > 0; }
+    void addDay(int day) { _days.insert(day); }
+    void keepEveryDay(const string output) { if (_skippedOutput.empty()) _skippedOutput = output; } // not resumed
+
+
+    // continues from the latest cached day no later than endDay, if any
+    bool restore(Community* community, SimulationState& state, int endDay) {
+        if (not _skippedOutput.empty()) {
+            cerr << "WARNING: not resuming from the snapshot cache, since the " << _skippedOutput << " of earlier days would be missing" << endl;
+            return false;
+        }
+        for (auto day = _days.rbegin(); day != _days.rend(); day++) {
+            if (*day > endDay or *day >= _par->nRunLength) continue;
+            const string path = _path(*day);
+            ifstream ifs(path.c_str(), ios::binary);
+            string description;
+            snapshot::read(ifs, description);
+            if (not ifs or description != _key(*day)) continue;
+            if (not read_snapshot(ifs, community, state)) {
+                cerr << "ERROR: could not restore cached snapshot " << path << "; remove it and run again" << endl;
+                exit(-840);
+            }
+            utime(path.c_str(), nullptr);                             // most recently used
+            if (not _par->abcVerbose) cerr << "resumed from cached snapshot of day " << *day << " (" << path << ")" << endl;
+            return true;
+        }
+        return false;
+    }
+
+    // caches the state at the start of today, if today is one of the cache's days and is not already cached
+    void store(const Community* community, const SimulationState& state) {
+        const int day = state.date.day();
+        if (_days.count(day) == 0) return;
+        const string path = _path(day);
+        struct stat info;
+        if (stat(path.c_str(), &info) == 0) return;
+        const string tmp = path + ".tmp" + to_string(getpid());      // written, then renamed, so a snapshot is never partial
+        ofstream ofs(tmp.c_str(), ios::binary);
+        snapshot::write(ofs, _key(day));
+        const bool written = ofs and write_snapshot(ofs, community, state);
+        ofs.close();
+        if (not written or not ofs or rename(tmp.c_str(), path.c_str()) != 0) {
+            cerr << "WARNING: could not cache snapshot of day " << day << " in " << path << endl;
+            remove(tmp.c_str());
+            return;
+        }
+        if (not _par->abcVerbose) cerr << "cached snapshot of day " << day << " (" << path << ")" << endl;
+        _evict(path);
+    }
+
+  private:
+    // the description of the snapshot of day: what determines the simulation up to its start
+    string _key(int day) const {
+        ostringstream key;
+        key.precision(17);                                            // so that any change of a number changes the key
+        key << _description << "; vector control:";
+        // in the order they start, since a campaign's random draws depend only on its start day and its place among the
+        // campaigns that start that day (see schedule_vector_control())
+        vector<VectorControlEvent> campaigns(_par->vectorControlEvents);
+        stable_sort(campaigns.begin(), campaigns.end(),
+                    [](const VectorControlEvent& a, const VectorControlEvent& b) { return a.campaignStart < b.campaignStart; });
+        for (const VectorControlEvent& vce: campaigns) {
+            if (vce.campaignStart >= day) continue;
+            key << " " << vce.campaignStart << " " << vce.campaignDuration << " " << vce.coverage << " " << vce.efficacy << " "
+                << vce.efficacyDuration << " " << vce.locationType << " " << vce.strategy << ",";
+        }
+        key << "; vaccination:";
+        for (const CatchupVaccinationEvent& cve: _par->catchupVaccinationEvents) {
+            if (cve.simDay < day) key << " " << cve.simDay << " " << cve.age << " " << cve.coverage << ",";
+        }
+        if (_par->vaccineTargetStartDate < day) {
+            key << " routine " << _par->vaccineTargetStartDate << " " << _par->vaccineTargetAge << " " << _par->vaccineTargetCoverage;
+        }
+        if (_par->vaccineTargetStartDate < day or any_of(_par->catchupVaccinationEvents.begin(), _par->catchupVaccinationEvents.end(),
+                                                         [day](const CatchupVaccinationEvent& cve) { return cve.simDay < day; })) {
+            key << "; vaccine: " << _par->numVaccineDoses << " " << _par->vaccineDoseInterval << " " << _par->vaccineBoosting << " "
+                << _par->vaccineBoostingInterval << " " << _par->linearlyWaningVaccine << " " << _par->vaccineImmunityDuration << " "
+                << _par->vaccineSeroConstraint << " " << _par->seroTestFalsePos << " " << _par->seroTestFalseNeg << " " << _par->whoDiseaseOutcome;
+        }
+        key << "; day " << day;
+        return key.str();
+    }
+    string _path(int day) const {
+        const string key = _key(day);
+        return _par->snapshotCacheDirectory + "/" + _hex(snapshot::digest(key.data(), key.size())) + ".snap";
+    }
+    static string _hex(uint64_t h) {
+        char buffer[17];
+        snprintf(buffer, sizeof(buffer), "%016llx", (unsigned long long) h);
+        return buffer;
+    }
+    static uint64_t _fileDigest(const string& filename) {
+        uint64_t h = snapshot::digest(filename.data(), filename.size());
+        ifstream ifs(filename.c_str(), ios::binary);
+        vector<char> buffer(1 << 20);
+        while (ifs) {
+            ifs.read(buffer.data(), buffer.size());
+            h = snapshot::digest(buffer.data(), ifs.gcount(), h);
+        }
+        return h;
+    }
+
+    // removes the least recently used snapshots (but not keep) until the cache is within its size limit
+    void _evict(const string& keep) const {
+        DIR* dir = opendir(_par->snapshotCacheDirectory.c_str());
+        if (not dir) return;
+        vector< pair< pair<time_t, long>, string> > snapshots;
+        double megabytes = 0;
+        map<string, double> size;
+        for (struct dirent* entry = readdir(dir); entry; entry = readdir(dir)) {
+            const string name = entry->d_name;
+            if (name.size() < 5 or name.compare(name.size() - 5, 5, ".snap") != 0) continue;
+            const string path = _par->snapshotCacheDirectory + "/" + name;
+            struct stat info;
+            if (stat(path.c_str(), &info) != 0) continue;
+            size[path] = info.st_size / 1048576.0;
+            megabytes += size[path];
+            if (path != keep) snapshots.emplace_back(make_pair(info.st_mtim.tv_sec, info.st_mtim.tv_nsec), path);
+        }
+        closedir(dir);
+        sort(snapshots.begin(), snapshots.end());
+        for (unsigned int i = 0; i < snapshots.size() and megabytes > _par->snapshotCacheMegabytes; i++) {
+            if (remove(snapshots[i].second.c_str()) == 0) {
+                megabytes -= size[snapshots[i].second];
+                if (not _par->abcVerbose) cerr << "removed cached snapshot " << snapshots[i].second << endl;
+            }
+        }
+    }
+
+    const Parameters* _par;
+    set<int> _days;
+    string _description;                                              // empty if there is no cache
+    string _skippedOutput;                                            // output that resuming would skip, if any
+};
+
+
+// Sets up the simulation's seasonality on day 0, or continues from the snapshot par->restoreFilename, or else from
+// the cache (if any), no later than the start of endDay (e.g., the day a burn-in branches)
+void start_simulation(const Parameters* par, Community* community, SimulationState& state, SnapshotCache* cache = nullptr, int endDay = INT_MAX) {
+    if (par->restoreFilename.length() > 0) {
+        if (not read_snapshot(par->restoreFilename, community, state)) exit(-840);
+        if (not par->abcVerbose) cerr << "restored snapshot of day " << state.date.day() << " from " << par->restoreFilename << endl;
+    } else if (not (cache and cache->restore(community, state, endDay))) {
+        initialize_seasonality(par, community, state.nextMosquitoMultiplierIndex, state.nextEIPindex, state.date);
+    }
+}
+
+
+// Simulates the day state.date, first writing any snapshot par asks for (or that the cache keeps), so a snapshot
+// holds only the vector control campaigns that start before its day; the caller advances the date
+void simulate_day(const Parameters* par, Community* community, SimulationState& state, const string process_id, SnapshotCache* cache = nullptr) {
+    if (cache) cache->store(community, state);
+    const auto snapshotFilename = par->snapshotFilenames.find(state.date.day());
+    if (snapshotFilename != par->snapshotFilenames.end()) {
+        if (not write_snapshot(snapshotFilename->second, community, state)) exit(-841);
+        if (not par->abcVerbose) cerr << "wrote snapshot of day " << state.date.day() << " to " << snapshotFilename->second << endl;
+    }
+    schedule_vector_control(par, community, state.date.day(), state.date.day() + 1);
+    update_vaccinations(par, community, state.date);
+    advance_simulator(par, community, state.date, process_id, state.periodic_incidence, state.periodic_prevalence, state.nextMosquitoMultiplierIndex, state.nextEIPindex, state.epi_sizes);
+}
+
+
+vector<int> simulate_epidemic_with_seroprev(const Parameters* par, Community* community, const string process_id, bool capture_sero_prev, vector< vector<double> > &sero_prev, int sero_prev_aggregation_julian_start=0) {
+    sero_prev = vector< vector<double> > (5, vector<double>(par->nRunLength/365, 0.0)); // rows are infection history: 0, 1, and 2+ infections
+    SimulationState state(par);
+    Date& date = state.date;
+    SnapshotCache snapshotCache(par);
+    if (capture_sero_prev) snapshotCache.keepEveryDay("seroprevalence");
+    SnapshotCache* cache = snapshotCache.enabled() ? &snapshotCache : nullptr;
+    start_simulation(par, community, state, cache);
     vector<string> daily_output_buffer;
 
     if (par->bSecondaryTransmission and not par->abcVerbose) {
         daily_output_buffer.push_back("day,year,id,age,location,vaccinated,serotype,symptomatic,severity");
     }
 
-    map<string, vector<int> > periodic_incidence = construct_tally();
-    vector<int> periodic_prevalence(NUM_OF_PREVALENCE_REPORTING_TYPES, 0);
-
     for (; date.day() < par->nRunLength; date.increment()) {
-        update_vaccinations(par, community, date);
-        advance_simulator(par, community, date, process_id, periodic_incidence, periodic_prevalence, nextMosquitoMultiplierIndex, nextEIPindex, epi_sizes);
+        simulate_day(par, community, state, process_id, cache);
         if (capture_sero_prev and (date.julianDay() == ((sero_prev_aggregation_julian_start+364) % 365 ) + 1)) { // +1 because julianDay is [1,365])), avg(avg(interventions are specified on [0,364]
             // tally current seroprevalence stats
-            int vaccinated_tally = 0;
-            vector<double> inf_ct_tally(5,0.0);         // [0,4] past infections
-            for (Person* p: community->getPeople()) {
-                // ignoring possible seroconversion due to vaccine
-                vaccinated_tally += p->isVaccinated();
-                const int ct = p->getNumNaturalInfections();
-                ++inf_ct_tally[ct];
-            }
+            // [0] is the number vaccinated; [1,5] the number with [0,4] past infections
+            const vector<int> tally = community->reducePeople(vector<int>(6, 0),
+                [](vector<int>& t, const Person* p) {
+                    // ignoring possible seroconversion due to vaccine
+                    t[0] += p->isVaccinated();
+                    ++t[1 + p->getNumNaturalInfections()];
+                },
+                [](vector<int>& t, const vector<int>& block) { for (unsigned int i = 0; i < t.size(); ++i) t[i] += block[i]; });
+            const int vaccinated_tally = tally[0];
+            const vector<double> inf_ct_tally(tally.begin() + 1, tally.end());
             double N = community->getNumPeople();
             for (unsigned int i = 0; i < inf_ct_tally.size(); ++i) sero_prev[i][date.year()] = inf_ct_tally[i] / N;
             cerr << "vaccinated N, fraction: " << vaccinated_tally << " " << (double) vaccinated_tally / N << endl;
@@ -517,7 +889,7 @@ vector<int> simulate_epidemic_with_seroprev(const Parameters* par, Community* co
     string dailyfilename = ss_filename.str();
     write_daily_buffer(daily_output_buffer, process_id, dailyfilename);
 */
-    return epi_sizes;
+    return state.epi_sizes;
 }
 
 
@@ -528,6 +900,169 @@ vector<int> simulate_epidemic(const Parameters* par, Community* community, const
 }
 
 
+// Simulates a burn-in shared by several scenarios once, then each scenario (branch) from where it ends.  The
+// burn-in is simulated with par up to the start of day branchDay, and its state is kept in memory as a snapshot
+// (see write_snapshot()).  Each branch k is restored from it into community, which is restarted with
+// branchPars[k] (so the branches must use the burn-in's input files, tiles and threads; see
+// Community::canRestart()), and simulated to the end of its run, after which finish(k, community) is called,
+// e.g. to write the branch's output.  From branchDay on, branch k draws from random streams given by its own seed,
+// k and branchDay (see RandomStreams::branchSeed()), which differ from the burn-in's and every other branch's even
+// if their seeds are the same.  The burn-in schedules only par's vector control campaigns that start before
+// branchDay, and each branch only its own that start on or after it, so a branch may drop or change a campaign
+// that par would start later.  A branch may change any option but the input files, tiles, threads and start
+// day of the year (see read_snapshot()); those that set what the snapshot holds take effect on branchDay: if its
+// mosquito capacity or distribution differ from par's, the locations' capacities are sampled again (see
+// Community::adoptParameters()), and its seasonal mosquito multipliers and EIPs, and whether there is secondary
+// transmission, replace par's.  The mosquitoes and people are as the burn-in left them.  Output lines are labeled
+// process_id.k.  If par has a snapshot cache, the burn-in
+// is resumed from (and its state on branchDay kept in) the cache, which it shares with whole runs with par; the
+// branches are not cached, since they are not what a simulation with their parameters alone would be.  Returns each branch's epi_sizes.
+vector< vector<int> > simulate_branches(const Parameters* par, Community* community, const int branchDay, const vector<const Parameters*>& branchPars,
+                                        const function<void(unsigned int, Community*)>& finish, const string process_id = "0") {
+    if (branchDay < 0 or branchDay > par->nRunLength) {
+        cerr << "ERROR: scenarios must branch on a day from 0 to the end of the burn-in run (" << par->nRunLength << ")" << endl;
+        exit(-842);
+    }
+    SimulationState state(par);
+    SnapshotCache snapshotCache(par);
+    snapshotCache.addDay(branchDay);
+    SnapshotCache* cache = snapshotCache.enabled() ? &snapshotCache : nullptr;
+    start_simulation(par, community, state, cache, branchDay);
+    for (; state.date.day() < branchDay; state.date.increment()) simulate_day(par, community, state, process_id, cache);
+    if (cache) cache->store(community, state);
+    stringstream burnin;
+    if (not write_snapshot(burnin, community, state)) exit(-841);
+
+    vector< vector<int> > epi_sizes;
+    for (unsigned int k = 0; k < branchPars.size(); k++) {
+        const Parameters* branchPar = branchPars[k];
+        if (not community->canRestart(branchPar)) {
+            cerr << "ERROR: scenario " << k << " does not use the burn-in's input files, spatial tiles and threads" << endl;
+            exit(-843);
+        }
+        SimulationState branch(branchPar);
+        burnin.clear();
+        burnin.seekg(0);
+        if (not community->restart(branchPar) or not read_snapshot(burnin, community, branch)) exit(-840);
+        community->reseed(RandomStreams::branchSeed(branchPar->randomseed, k, branchDay));
+        if (not community->adoptParameters(par)) exit(-840);
+        // the seasonal periods the branch is in at the start of branchDay, i.e. as of the day before (if any)
+        set_seasonality(branchPar, community, branch.nextMosquitoMultiplierIndex, branch.nextEIPindex, branch.date.offset() + max(branchDay - 1, 0));
+        const string branch_id = process_id + "." + to_string(k);
+        for (; branch.date.day() < branchPar->nRunLength; branch.date.increment()) simulate_day(branchPar, community, branch, branch_id);
+        finish(k, community);
+        epi_sizes.push_back(branch.epi_sizes);
+    }
+    return epi_sizes;
+}
+
+
+// Reads a batch of jobs (see -batch in driver.cpp, and mpi_driver.cpp): each line is one job, given as options to
+// add to the command line.  Blank lines and lines starting with # are skipped.
+bool read_jobs(const string filename, vector<string>& jobs) {
+    ifstream iss(filename.c_str());
+    if (!iss) {
+        cerr << "ERROR: " << filename << " not found." << endl;
+        return false;
+    }
+    string buffer;
+    while (getline(iss, buffer)) {
+        const size_t first = buffer.find_first_not_of(" \t\r");
+        if (first == string::npos or buffer[first] == '#') continue;
+        jobs.push_back(buffer);
+    }
+    iss.close();
+    return true;
+}
+
+
+// Parameters for job n of a batch: the job's options are added to args (a command line, which may set them too;
+// the job's take precedence), and ".n" to the names of any output files, so that each job writes its own.
+Parameters* job_parameters(const vector<string>& args, const string job, const int n) {
+    vector<string> jobargs(args);
+    istringstream iss(job);
+    string arg;
+    while (iss >> arg) jobargs.push_back(arg);
+    vector<char*> argv;
+    for (string& a: jobargs) argv.push_back(&a[0]);
+    argv.push_back(nullptr);
+
+    Parameters* par = new Parameters(jobargs.size(), argv.data());
+    par->defineSerotypeRelativeRisks();
+    const string suffix = "." + to_string(n);
+    if (par->peopleOutputFilename.length() > 0) par->peopleOutputFilename += suffix;
+    if (par->yearlyPeopleOutputFilename.length() > 0) par->yearlyPeopleOutputFilename += suffix;
+    if (par->dailyOutputFilename.length() > 0) par->dailyOutputFilename += suffix;
+    for (auto &snapshot: par->snapshotFilenames) snapshot.second += suffix;
+    return par;
+}
+
+
+// Simulates one job of a batch with par, and writes its output.  community is restarted for the job if it was built
+// from the same files, or else replaced by a new community (see reuse_community()); afterward it holds the job's
+// results, and must be deleted before par.  Returns the yearly reported cases, as simulate_epidemic() does.
+vector<int> simulate_job(const Parameters* par, Community*& community, const string process_id) {
+    community = reuse_community(par, community);
+    vector<int> initial_susceptibles = community->getNumSusceptible();
+    seed_epidemic(par, community);
+    vector<int> epi_sizes = simulate_epidemic(par, community, process_id);
+    write_output(par, community, initial_susceptibles);
+    return epi_sizes;
+}
+
+
+// One replicate of an ensemble (see simulate_ensemble()), and the state its simulation carries from day to day
+struct Replicate : SimulationState {
+    Replicate(const Parameters* p, Community* c, const string id) : SimulationState(p), par(p), community(c), process_id(id) {}
+    const Parameters* par;
+    Community* community;
+    const string process_id;
+    string output;                                                    // the day's output lines, until they are written
+};
+
+
+// Simulates communities[k] with pars[k] for each k, as simulate_epidemic() would, but in lockstep: every replicate
+// finishes a day before any starts the next, and the replicates of a day run in parallel on nthreads threads
+// (pinned from firstcore, if not negative; see ThreadPool.h).  Each day's output lines are written once the day
+// is over, in replicate order.  Replicates made by replicate_community() share everything that does not change
+// during a run (people's ages, sexes and locations, locations' coordinates and neighbors, mosquito movement, swap
+// probabilities and initial immunity), which every replicate reads in turn while it is still in cache; each has
+// its own people's immune and infection state, and its own locations' occupants, mosquitoes and vector control.
+// Returns each replicate's epi_sizes.
+vector< vector<int> > simulate_ensemble(const vector<const Parameters*>& pars, const vector<Community*>& communities, unsigned int nthreads, int firstcore = -1) {
+    assert(pars.size() == communities.size());
+    vector<Replicate> replicates;
+    replicates.reserve(pars.size());
+    int runLength = 0;
+    for (unsigned int k = 0; k < pars.size(); k++) {
+        replicates.emplace_back(pars[k], communities[k], to_string(k));
+        Replicate& r = replicates.back();
+        initialize_seasonality(r.par, r.community, r.nextMosquitoMultiplierIndex, r.nextEIPindex, r.date);
+        schedule_vector_control(r.par, r.community);
+        runLength = max(runLength, r.par->nRunLength);
+    }
+
+    ThreadPool threads(nthreads, firstcore);
+    for (int day = 0; day < runLength; day++) {
+        threads.run(replicates.size(), [&](unsigned int k) {
+            Replicate& r = replicates[k];
+            if (r.date.day() >= r.par->nRunLength) return;
+            update_vaccinations(r.par, r.community, r.date);
+            advance_simulator(r.par, r.community, r.date, r.process_id, r.periodic_incidence, r.periodic_prevalence, r.nextMosquitoMultiplierIndex, r.nextEIPindex, r.epi_sizes, &r.output);
+            r.date.increment();
+        });
+        for (Replicate& r: replicates) {
+            fputs(r.output.c_str(), stdout);
+            r.output.clear();
+        }
+    }
+
+    vector< vector<int> > epi_sizes;
+    for (Replicate& r: replicates) epi_sizes.push_back(r.epi_sizes);
+    return epi_sizes;
+}
+
+
 vector<long double> simulate_who_fitting(const Parameters* par, Community* community, const string process_id, vector<int> &serotested_ids) {
     assert(serotested_ids.size() > 0);
     vector<long double> metrics;
@@ -594,23 +1129,31 @@ vector<int> simulate_abc(const Parameters* par, Community* community, const stri
                                                                // for a simulation starting Jan 1, 1879
             cerr << "1987 serosurvey\n";
             // calculate seroprevalence among 8-14 year old merida residents
-            for (int id: serotested_ids_87) {
-                const double seropos = community->getPersonByID(id)->getNumNaturalInfections() > 0 ? 1.0 : 0.0;
-                seropos_87 += seropos;
-            }
+            seropos_87 += community->reduce(serotested_ids_87.size(), 0.0,
+                [&](double& seropos, unsigned int i) {
+                    seropos += community->getPersonByID(serotested_ids_87[i])->getNumNaturalInfections() > 0 ? 1.0 : 0.0;
+                },
+                [](double& seropos, double block) { seropos += block; });
             seropos_87 /= serotested_ids_87.size();
         } else if ( date.julianDay() == 99 and date.year() == 135 ) { // This corresponds to April 9 (day 99) of 2014
             cerr << "2014 serosurvey\n";
             // calculate seroprevalence among all merida residents
-            for (int id: serotested_ids_14) {
-                const Person* p = community->getPersonByID(id);
-                const int age = p->getAge();
-                assert(age >= 0);
-                unsigned int age_cat;
-                for (age_cat = 0; age_cat<upper_age_bound_14.size() and age>upper_age_bound_14[age_cat]; ++age_cat) {/*this space intentionally left blank*/}
-                const double seropos = p->getNumNaturalInfections() > 0 ? 1.0 : 0.0;
-                seropos_14_by_age[age_cat] += seropos;
-                seropos_14_sample_size[age_cat]++;
+            // seropositive counts by age category, then sample sizes
+            const unsigned int ncats = upper_age_bound_14.size();
+            const vector<int> tally = community->reduce(serotested_ids_14.size(), vector<int>(2*ncats, 0),
+                [&](vector<int>& t, unsigned int i) {
+                    const Person* p = community->getPersonByID(serotested_ids_14[i]);
+                    const int age = p->getAge();
+                    assert(age >= 0);
+                    unsigned int age_cat;
+                    for (age_cat = 0; age_cat<ncats and age>upper_age_bound_14[age_cat]; ++age_cat) {/*this space intentionally left blank*/}
+                    if (p->getNumNaturalInfections() > 0) t[age_cat]++;
+                    t[ncats + age_cat]++;
+                },
+                [](vector<int>& t, const vector<int>& block) { for (unsigned int i = 0; i < t.size(); ++i) t[i] += block[i]; });
+            for (unsigned int age_cat = 0; age_cat < ncats; ++age_cat) {
+                seropos_14_by_age[age_cat] += tally[age_cat];
+                seropos_14_sample_size[age_cat] += tally[ncats + age_cat];
             }
             for (unsigned int age_cat = 0; age_cat < seropos_14_by_age.size(); ++age_cat) {
                 seropos_14_by_age[age_cat] /= seropos_14_sample_size[age_cat];
@@ -677,18 +1220,23 @@ void write_immunity_by_age_file(const Community* community, const int year, stri
         filename = ss_filename.str();
     }
     // total count, denv1, denv2, denv3, denv4, imm_to_one, imm_to_all
-    vector< vector<int> > tally(NUM_AGE_CLASSES, vector<int>(NUM_OF_SEROTYPES+3, 0));
-    for (Person* p: community->getPeople()) {
-        const int age = p->getAge();
-        tally[age][0]++;
-        const int numInfections = p->getNumNaturalInfections();
-        for (int k = 0; k<numInfections; ++k) {
-            const int s = (int) p->getSerotype(k);
-            tally[age][s+1]++;
-        }
-        if (numInfections > 0) tally[age][NUM_OF_SEROTYPES+1]++;
-        if (numInfections == NUM_OF_SEROTYPES) tally[age][NUM_OF_SEROTYPES+2]++;
-    }
+    const vector< vector<int> > tally = community->reducePeople(vector< vector<int> >(NUM_AGE_CLASSES, vector<int>(NUM_OF_SEROTYPES+3, 0)),
+        [](vector< vector<int> >& tally, const Person* p) {
+            const int age = p->getAge();
+            tally[age][0]++;
+            const int numInfections = p->getNumNaturalInfections();
+            for (int k = 0; k<numInfections; ++k) {
+                const int s = (int) p->getSerotype(k);
+                tally[age][s+1]++;
+            }
+            if (numInfections > 0) tally[age][NUM_OF_SEROTYPES+1]++;
+            if (numInfections == NUM_OF_SEROTYPES) tally[age][NUM_OF_SEROTYPES+2]++;
+        },
+        [](vector< vector<int> >& tally, const vector< vector<int> >& block) {
+            for (int a = 0; a<NUM_AGE_CLASSES; ++a) {
+                for (unsigned int i = 0; i < tally[a].size(); ++i) tally[a][i] += block[a][i];
+            }
+        });
 
     ofstream file;
     file.open(filename);
@@ -725,19 +1273,8 @@ void write_immunity_file(const Community* community, const string label, string
 
 
 void daily_detailed_output(Community* community, int t) {
-    // print out infectious mosquitoes
-/*    for (int i=community->getNumInfectiousMosquitoes()-1; i>=0; i--) {
-        Mosquito *p = community->getInfectiousMosquito(i);
-        cout << t << ",mi," << p->getID() << "," << p->getLocation()->getID() << "," << "," << "," << endl;
-    }
-    // print out exposed mosquitoes
-    for (int i=community->getNumExposedMosquitoes()-1; i>=0; i--) {
-        Mosquito *p = community->getExposedMosquito(i);
-        // "current" location
-        cout << t << ",me," << p->getID() << "," << p->getLocation()->getID() << "," << 1 + (int) p->getSerotype() << "," << "," << "," << endl;
-    }*/
     // print out infected people
-    for (Person *p: community->getPeople()) {
+    for (Person *p: community->getActiveInfections()) {
         if (p->isInfected(t)) {
             // home location
             cout << t
@@ -757,25 +1294,49 @@ void write_mosquito_location_data(const Community* community, string mos_filenam
     ofstream mos_file;
     mos_file.open(mos_filename);
     mos_file << "locID sero queue idx ageInfd ageInfs ageDead\n";
-    const vector< vector<Mosquito*> > exposed = community->getExposedMosquitoes();
+    const vector<SpatialTile*>& tiles = community->getTiles();
     // Exposed mosquitoes, by incubation days left
-    for (unsigned int i = 0; i < exposed.size(); ++i) {
-        const vector<Mosquito*>& mosquitoes = exposed[i];
-        for (const Mosquito* m: mosquitoes) {
-            mos_file << m->getLocation()->getID() << " " << m->getSerotype()    << " "
-                     << "e " << i                 << " " << m->getAgeInfected() << " "
-                     << m->getAgeInfectious()     << " " << m->getAgeDeath()    << endl;
+    for (unsigned int i = 0; i < MAX_MOSQUITO_AGE+1; ++i) {
+        for (const SpatialTile* tile: tiles) {
+            const MosquitoPool& pool = tile->mosquitoes;
+            for (unsigned int m: tile->exposedMosquitoQueue[i]) {
+                mos_file << pool.getLocationID(m)     << " " << pool.getSerotype(m)    << " "
+                         << "e " << i                 << " " << pool.getAgeInfected(m) << " "
+                         << pool.getAgeInfectious(m)  << " " << pool.getAgeDeath(m)    << endl;
+            }
         }
     }
 
-    const vector< vector<Mosquito*> > infectious = community->getInfectiousMosquitoes();
     // Infectious mosquitoes, by days left to live
-    for (unsigned int i = 0; i < infectious.size(); ++i) {
-        const vector<Mosquito*>& mosquitoes = infectious[i];
-        for (const Mosquito* m: mosquitoes) {
-            mos_file << m->getLocation()->getID() << " " << m->getSerotype()    << " "
-                     << "i " << i                 << " " << m->getAgeInfected() << " "
-                     << m->getAgeInfectious()     << " " << m->getAgeDeath()    << endl;
+    for (unsigned int i = 0; i < MAX_MOSQUITO_AGE+1; ++i) {
+        for (const SpatialTile* tile: tiles) {
+            const MosquitoPool& pool = tile->mosquitoes;
+            for (unsigned int m: tile->infectiousMosquitoQueue[i]) {
+                mos_file << pool.getLocationID(m)     << " " << pool.getSerotype(m)    << " "
+                         << "i " << i                 << " " << pool.getAgeInfected(m) << " "
+                         << pool.getAgeInfectious(m)  << " " << pool.getAgeDeath(m)    << endl;
+            }
+        }
+    }
+
+    // Mosquitoes in cohorts (compartmental model) have no individual ages, so each is written with ages
+    // counted from the start of its infectious period; this is enough to restore it with either model
+    for (unsigned int i = 0; i < MAX_MOSQUITO_AGE+1; ++i) {
+        for (const SpatialTile* tile: tiles) {
+            for (const MosquitoCohort &c: tile->exposedMosquitoCohorts[i]) {
+                for (int n = 0; n < c.count; ++n) {
+                    mos_file << c.locationID << " " << c.serotype << " e " << i << " 0 0 " << c.daysInfectious << endl;
+                }
+            }
+        }
+    }
+    for (unsigned int i = 0; i < MAX_MOSQUITO_AGE+1; ++i) {
+        for (const SpatialTile* tile: tiles) {
+            for (const MosquitoCohort &c: tile->infectiousMosquitoCohorts[i]) {
+                for (int n = 0; n < c.count; ++n) {
+                    mos_file << c.locationID << " " << c.serotype << " i " << i << " 0 0 " << i << endl;
+                }
+            }
         }
     }
     mos_file.close();